@@ -0,0 +1,15 @@
+#pragma once
+
+// Stand-in for jetson-utils' logging.h, used when jetson-utils is not
+// installed so the tools still build. Messages go to stdout (errors and
+// warnings to stderr) at jetson-utils' default level: verbose and debug
+// output is dropped.
+
+#include <cstdio>
+
+#define LogError(...) fprintf(stderr, __VA_ARGS__)
+#define LogWarning(...) fprintf(stderr, __VA_ARGS__)
+#define LogSuccess(...) printf(__VA_ARGS__)
+#define LogInfo(...) printf(__VA_ARGS__)
+#define LogVerbose(...) ((void)0)
+#define LogDebug(...) ((void)0)
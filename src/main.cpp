@@ -1,3 +1,6 @@
+#include <csignal>
+#include <ctime>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -7,16 +10,109 @@
 #include <jetson-utils/gstEncoder.h>
 #include <jetson-utils/gstUtility.h>
 
+#include "peopleDetector/AllocTracker.hpp"
+#include "peopleDetector/Appearance.hpp"
+#include "peopleDetector/Checkpoint.hpp"
+#include "peopleDetector/CountArchive.hpp"
+#include "peopleDetector/Config.hpp"
+#include "peopleDetector/CountPublisher.hpp"
 #include "peopleDetector/Counter.hpp"
+#include "peopleDetector/CpuPeopleDetector.hpp"
 #include "peopleDetector/Detection.hpp"
+#include "peopleDetector/DetectionLog.hpp"
+#include "peopleDetector/DetectionRing.hpp"
+#include "peopleDetector/EventWriter.hpp"
+#include "peopleDetector/FrameTrace.hpp"
+#include "peopleDetector/Heatmap.hpp"
+#include "peopleDetector/LoadShedder.hpp"
+#include "peopleDetector/Metrics.hpp"
+#include "peopleDetector/MetricsServer.hpp"
+#include "peopleDetector/MotionGate.hpp"
+#ifndef PEOPLECOUNTER_CPU_DETECTOR
 #include "peopleDetector/PeopleDetector.hpp"
+#endif
+#include "peopleDetector/ThreadPolicy.hpp"
 #include "peopleDetector/Tracker.hpp"
+#include "peopleDetector/WorkStealingPool.hpp"
 
 std::mutex cout_mtx_;
+using peopleDetector::AllocTracker;
+using peopleDetector::Checkpoint;
+using peopleDetector::Config;
+using peopleDetector::ConfigWatcher;
+using peopleDetector::CountArchive;
+using peopleDetector::CountPublisher;
 using peopleDetector::Counter;
+using peopleDetector::CpuPeopleDetector;
+using peopleDetector::CrossingEventRing;
+using peopleDetector::DetectionLogWriter;
+using peopleDetector::DetectionLease;
+using peopleDetector::DetectionRing;
+using peopleDetector::EventWriter;
+using peopleDetector::FrameTrace;
+using peopleDetector::Heatmap;
+using peopleDetector::LoadShedder;
+using peopleDetector::Metrics;
+using peopleDetector::MetricsServer;
+using peopleDetector::MotionGate;
+#ifndef PEOPLECOUNTER_CPU_DETECTOR
 using peopleDetector::PeopleDetector;
+#endif
+using peopleDetector::ScopedSpan;
+using peopleDetector::Stage;
+using peopleDetector::StageTimer;
+using peopleDetector::ThreadRole;
 using peopleDetector::Tracker;
+using peopleDetector::WorkStealingPool;
 bool signal_recieved = false;
+volatile sig_atomic_t trace_requested = 0;
+volatile sig_atomic_t threads_requested = 0; // SIGUSR2 logs CPU placement and context switches per thread
+
+// Skip inference on frames where nothing in the scene has changed
+const bool enableMotionGate = true;
+
+// Wide-angle views: also run the network on crops along the counting line
+// and around the predicted tracks, so far-field people are detected at a
+// usable scale (TilePlanner.hpp). Costs up to four extra passes per frame.
+const bool enableTiling = false;
+const int maxTilePredictions = 64;
+
+// Crowded scenes: pool threads that associate independent groups of tracks
+// in parallel, 0 to associate on the tracker's thread only
+const int associationThreads = 2;
+
+// Crossing events as JSON lines, "unix:/path" streams them to a local socket
+const std::string eventTarget{"crossings.jsonl"};
+
+// Text-format metrics endpoint, "host:port" or "unix:/path"
+const std::string metricsTarget{"127.0.0.1:9102"};
+
+// SIGUSR1 dumps the recent frame spans to <prefix><frame>.json (Chrome trace format)
+const std::string tracePrefix{"trace-"};
+
+// Thresholds and counting lines, reloaded when the file changes
+const std::string configPath{"peoplecounter.conf"};
+
+// Counters, time buckets and live tracks survive a restart through this file
+const std::string checkpointPath{"peoplecounter.ckpt"};
+
+// Per-minute in/out history for range queries with PeopleCounterArchive
+const std::string archivePath{"peoplecounter.archive"};
+
+// Detector output of every frame goes to <prefix><start time>.detlog, for
+// re-scoring with PeopleCounterBatch after a config change. Off by default:
+// it writes on the frame thread, and stops at the size limit.
+const bool recordDetections = false;
+const uint64_t detectionLogMaxBytes = 1ull << 30;
+const std::string detectionLogPrefix{"detections-"};
+
+// Occupancy grid of all tracks, exported as a raw grid (see HeatmapFileHeader)
+// from a thread of its own
+const std::string heatmapPath{"heatmap.bin"};
+const int heatmapExportIntervalMs = 60000;
+
+// Frames before allocation tracking builds expect a zero-allocation steady state
+const int allocWarmupFrames = 300;
 
 void sig_handler(int signo)
 {
@@ -24,26 +120,87 @@ void sig_handler(int signo)
 		LogVerbose("received SIGINT\n");
 		signal_recieved = true;
 	}
+	if (signo == SIGUSR1)
+		trace_requested = 1;
+	if (signo == SIGUSR2)
+		threads_requested = 1;
 }
 int main()
 {
+	signal(SIGINT, sig_handler);
+	signal(SIGUSR1, sig_handler);
+	signal(SIGUSR2, sig_handler);
+
+	ConfigWatcher configWatcher(configPath);
+	configWatcher.start();
+
 	static Counter counter(0);
+	static CrossingEventRing crossingEvents;
+	static Heatmap heatmap(1280, 720);
 	Tracker tracker(counter);
+	tracker.setEventRing(crossingEvents);
+	tracker.setHeatmap(heatmap);
+	heatmap.startExport(heatmapPath, heatmapExportIntervalMs);
+	std::unique_ptr<WorkStealingPool> associationPool;
+	if (associationThreads > 0) {
+		associationPool.reset(new WorkStealingPool(associationThreads, ThreadRole::TRACK, "associate"));
+		tracker.setAssociationPool(associationPool.get());
+	}
+	Checkpoint checkpoint(checkpointPath);
+	if (checkpoint.open())
+		checkpoint.restore(counter, tracker);
+	CountArchive countArchive(archivePath);
+	countArchive.open();
+	EventWriter eventWriter(crossingEvents, eventTarget);
+	eventWriter.start();
+	CountPublisher countPublisher;
+	if (!countPublisher.open())
+		LogError("PeopleCounter:  live counts will not be published to shared memory\n");
+	static Metrics metrics;
+	MetricsServer metricsServer(metrics, counter, metricsTarget);
+	metricsServer.start();
+	static FrameTrace frameTrace;
+	// GStreamer threads inherit the placement of the thread starting the
+	// pipeline, which Open() does. The main thread keeps its name, which is
+	// the process name.
+	peopleDetector::applyThreadRole(ThreadRole::CAPTURE, nullptr);
 	gstCamera *input = gstCamera::Create(1280, 720);
+	if (input && !input->Open()) {
+		LogError("PeopleCounter:  failed to start the camera\n");
+		SAFE_DELETE(input);
+	}
+	peopleDetector::applyThreadRole(ThreadRole::DETECT, nullptr);
 
 	if (!input)
 		return -1;
 
+#ifdef PEOPLECOUNTER_CPU_DETECTOR
+	auto net = std::make_unique<CpuPeopleDetector>();
+#else
 	const std::string model{"ssd-mobilenet-v1"};
 
 	auto net = PeopleDetector::Create(model);
 	net->setCounter(counter);
+#endif
 
 	glDisplay* output = glDisplay::Create();
+	MotionGate motionGate;
+	LoadShedder loadShedder(metrics);
+	DetectionLogWriter detectionLog;
+	if (recordDetections)
+		detectionLog.open(detectionLogPrefix + std::to_string(time(nullptr)) + ".detlog", input->GetWidth(), input->GetHeight(),
+				  detectionLogMaxBytes);
 
 
 	// detect objects in the frame
-	peopleDetector::Detection* detections = NULL;
+	DetectionLease detections;
+	std::vector<float> predictions(2 * maxTilePredictions);
+
+	// Reused every frame. Entries point straight into the leased detection
+	// set, which goes back to the detector once the tracker, the track
+	// threads and the overlay have all dropped them.
+	Tracker::DetectionVec frameDetections;
+	int zoneOccupancy[Config::maxZones];
 
 	// Main loop
 	int idx = 0;
@@ -51,47 +208,175 @@ int main()
 
 		// 1. Read in frame detections
 		uchar3* image{nullptr};
-		if (input->Capture(&image, 200) == false) {
+		const uint32_t frameId = idx;
+		const int64_t captureStart = FrameTrace::nowNs();
+		{
+			StageTimer timer(metrics, Stage::CAPTURE, &frameTrace, frameId);
+			if (input->Capture(&image, 200) == false) {
+
+				continue;
+			}
+		}
+		loadShedder.frameCaptured(FrameTrace::nowNs() - captureStart);
 
-			continue;
+		// A frame already past the latency budget only advances the
+		// tracker, so the loop catches up with the camera
+		const bool dropped = loadShedder.dropFrame();
+		// The frame span starts before the capture and ends after rendering
+		StageTimer frameTimer(metrics, Stage::FRAME, &frameTrace, frameId, captureStart);
+		const uint64_t frameAllocations = AllocTracker::getPipelineAllocations();
+		uint64_t exemptAllocations = 0;
+
+		frameDetections.clear();
+		int numDetections = 0;
+		bool inferred = false; // Without inference the tracks only predict
+		{
+			StageTimer timer(metrics, Stage::DETECT, &frameTrace, frameId);
+
+			// Static frames skip the network. The gate only applies to an
+			// empty scene: someone standing still soon becomes background,
+			// so inference keeps running while any track is live.
+			bool motion = true;
+			if (enableMotionGate && !dropped) {
+				ScopedSpan span(frameTrace, "MotionGate::hasMotion", frameId);
+				motion = motionGate.hasMotion(image, input->GetWidth(), input->GetHeight()) || tracker.getLiveTrackCount() > 0;
+			}
+			if (!motion) {
+				LogVerbose("PeopleCounter:  static frame skipped (motion gate %.0f us)\n", motionGate.getLastCostUs());
+				++metrics.skippedFrames;
+			} else if (!dropped && !loadShedder.skipInference()) {
+				ScopedSpan span(frameTrace, "Detect", frameId);
+#ifndef PEOPLECOUNTER_CPU_DETECTOR
+				if (enableTiling) {
+					const int numPredictions = tracker.getPredictions(predictions.data(), maxTilePredictions);
+					numDetections = net->DetectTiles(image, input->GetWidth(), input->GetHeight(), predictions.data(),
+									 numPredictions, detections);
+				} else
+#endif
+					numDetections = net->Detect(image, input->GetWidth(), input->GetHeight(), detections);
+				inferred = numDetections >= 0;
+			}
+
+			std::cout << "Frame idx:" << idx << " numDetections:" << numDetections << std::endl;
+			ScopedSpan span(frameTrace, "computeAppearance", frameId);
+			for (int n = 0; n < numDetections; ++n) {
+				auto det = DetectionRing::share(detections, n);
+				peopleDetector::computeAppearance(image, input->GetWidth(), input->GetHeight(), *det);
+				frameDetections.push_back(det);
+			}
 		}
-		const int numDetections = net->Detect(image, input->GetWidth(), input->GetHeight(), &detections);
+		{
+			StageTimer timer(metrics, Stage::TRACK, &frameTrace, frameId);
+
+			// A frame without inference is no evidence of absence: tracks
+			// predict without counting a miss, init tracks survive
+			if (!inferred) {
+				tracker.elapse(idx);
+			} else {
+				tracker.setNewDetections(idx, frameDetections);
 
-		Tracker::DetectionVec frameDetections;
+				// 2. Associate detections (measurements) to existing tracks
+				{
+					ScopedSpan span(frameTrace, "Tracker::associate", frameId);
+					tracker.associate();
+				}
+				// Modifies _newDetections, only unassociated new detections
+				// remain
 
-		std::cout << "Frame idx:" << idx << " numDetections:" << numDetections << std::endl;
-		for (int n = 0; n < numDetections; ++n) {
-			frameDetections.push_back(std::make_shared<peopleDetector::Detection>(detections[n]));
+				// 3. Create new tracks from unassociated measurements
+				ScopedSpan span(frameTrace, "Tracker::createNewTracks", frameId);
+				const uint64_t birthAllocations = AllocTracker::getPipelineAllocations();
+				if (tracker.createNewTracks() > 0)
+					exemptAllocations += AllocTracker::getPipelineAllocations() - birthAllocations;
+			}
 		}
-		tracker.setNewDetections(idx, frameDetections);
 
-		// 2. Associate detections (measurements) to existing tracks
-		tracker.associate();
-		// Modifies _newDetections, only unassociated new detections
-		// remain
+		{
+			StageTimer outputTimer(metrics, Stage::OUTPUT, &frameTrace, frameId);
 
-		// 3. Create new tracks from unassociated measurements
-		tracker.createNewTracks();
+			// 4. Publish counts to local readers (shared-memory seqlock) and
+			// the metrics endpoint
+			const Config& config = peopleDetector::currentConfig();
+			tracker.getZoneOccupancy(config, zoneOccupancy);
+			countPublisher.publish(counter, idx, 1 + config.numGateLines, zoneOccupancy, config.numZones);
+			if (inferred)
+				detectionLog.write(frameId, frameDetections); // Replays elapse the frames in between
+			checkpoint.update(counter, tracker, idx);
+			countArchive.update(counter);
+			metrics.frames.store(idx + 1, std::memory_order_relaxed);
+			metrics.liveTracks.store(tracker.getLiveTrackCount(), std::memory_order_relaxed);
+			const DetectionRing& detectionRing = net->GetDetectionRing();
+			metrics.leasedDetectionSets.store(detectionRing.getLeased(), std::memory_order_relaxed);
+			metrics.detectionLeaseWaits.store(detectionRing.getWaits(), std::memory_order_relaxed);
+			metrics.detectionLeaseTimeouts.store(detectionRing.getTimeouts(), std::memory_order_relaxed);
+			metrics.eventQueueDepth.store(crossingEvents.getDepth(), std::memory_order_relaxed);
+			metrics.eventsDropped.store(crossingEvents.getDropped() + eventWriter.getDropped(), std::memory_order_relaxed);
+#ifndef PEOPLECOUNTER_CPU_DETECTOR
+			metrics.networkFps.store(net->GetNetworkFPS(), std::memory_order_relaxed);
+#endif
 
-		// 5. Update visuals
-		net->UpdateVisuals(image, input->GetWidth(), input->GetHeight(), numDetections, frameDetections);
+			// 5. Update visuals
+#ifndef PEOPLECOUNTER_CPU_DETECTOR
+			if (!loadShedder.skipOverlay()) {
+				ScopedSpan span(frameTrace, "UpdateVisuals", frameId);
+				net->UpdateVisuals(image, input->GetWidth(), input->GetHeight(), numDetections, frameDetections);
+			}
+#endif
 
-		if (output != NULL) {
-			output->Render(image, input->GetWidth(), input->GetHeight());
+			if (output != NULL) {
+				const uint64_t renderAllocations = AllocTracker::getPipelineAllocations();
+				if (!dropped) {
+					ScopedSpan span(frameTrace, "glDisplay::Render", frameId);
+					output->Render(image, input->GetWidth(), input->GetHeight());
+				}
 
-			char str[256];
-			sprintf(str, "TensorRT %i.%i.%i | %s | Network %.0f FPS", NV_TENSORRT_MAJOR, NV_TENSORRT_MINOR, NV_TENSORRT_PATCH,
-				precisionTypeToStr(net->GetPrecision()), net->GetNetworkFPS());
-			output->SetStatus(str);
+				char str[256];
+#ifdef PEOPLECOUNTER_CPU_DETECTOR
+				sprintf(str, "CPU detector | Status: %i, In: %i, Out: %i", counter.getStatus(), counter.getEntered(), counter.getLeft());
+#else
+				sprintf(str, "TensorRT %i.%i.%i | %s | Network %.0f FPS", NV_TENSORRT_MAJOR, NV_TENSORRT_MINOR, NV_TENSORRT_PATCH,
+					precisionTypeToStr(net->GetPrecision()), net->GetNetworkFPS());
+#endif
+				output->SetStatus(str);
 
-			// check if the user quit
-			if (!output->IsStreaming())
-				signal_recieved = true;
+				// check if the user quit
+				if (!output->IsStreaming())
+					signal_recieved = true;
+				exemptAllocations += AllocTracker::getPipelineAllocations() - renderAllocations;
+			}
+		}
+
+		// Once warmed up, the frame (this thread and the track threads) must
+		// not allocate. Only what was measured inside starting a track and
+		// the display is exempt; PeopleCounterAllocs fails on the same rule.
+		if (AllocTracker::enabled() && idx >= allocWarmupFrames) {
+			const uint64_t allocations = AllocTracker::getPipelineAllocations() - frameAllocations - exemptAllocations;
+			if (allocations > 0) {
+				LogError("PeopleCounter:  frame %i made %llu steady-state allocations\n", idx, (unsigned long long)allocations);
+				++metrics.allocationRegressions;
+			}
+		}
+
+		loadShedder.frameDone();
+
+		if (trace_requested) {
+			trace_requested = 0;
+			frameTrace.dump(tracePrefix + std::to_string(idx) + ".json");
+		}
+		if (threads_requested) {
+			threads_requested = 0;
+			peopleDetector::reportThreads();
 		}
 
 		++idx;
 	}
 	LogVerbose("PeopleCounter:  shutting down...\n");
+	peopleDetector::reportThreads();
+
+	metricsServer.stop();
+	configWatcher.stop();
+	eventWriter.stop();
+	heatmap.stopExport();
 
 	SAFE_DELETE(input);
 	SAFE_DELETE(output);
@@ -0,0 +1,83 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocTracker.hpp"
+
+namespace
+{
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> bytes{0};
+std::atomic<uint64_t> pipelineAllocations{0};
+thread_local uint64_t threadAllocations = 0;
+thread_local bool threadExcluded = false;
+} // namespace
+
+namespace peopleDetector
+{
+
+bool AllocTracker::enabled()
+{
+#ifdef PEOPLECOUNTER_ALLOC_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t AllocTracker::getAllocations() { return allocations.load(std::memory_order_relaxed); }
+
+uint64_t AllocTracker::getBytes() { return bytes.load(std::memory_order_relaxed); }
+
+uint64_t AllocTracker::getThreadAllocations() { return threadAllocations; }
+
+void AllocTracker::excludeThread() { threadExcluded = true; }
+
+uint64_t AllocTracker::getPipelineAllocations() { return pipelineAllocations.load(std::memory_order_relaxed); }
+} // namespace peopleDetector
+
+#ifdef PEOPLECOUNTER_ALLOC_TRACKING
+
+static inline void* trackedMalloc(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add(size, std::memory_order_relaxed);
+	++threadAllocations;
+	if (!threadExcluded)
+		pipelineAllocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+	void* p = trackedMalloc(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* p = trackedMalloc(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return trackedMalloc(size); }
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return trackedMalloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
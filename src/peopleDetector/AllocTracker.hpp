@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace peopleDetector
+{
+
+/**
+ * Heap allocation counters. With PEOPLECOUNTER_ALLOC_TRACKING defined the
+ * global operator new/delete are replaced by counting wrappers around
+ * malloc/free; otherwise the counters stay at zero and enabled() is false.
+ */
+class AllocTracker
+{
+      public:
+	static bool enabled();
+	static uint64_t getAllocations();	// All threads
+	static uint64_t getBytes();		// All threads
+	static uint64_t getThreadAllocations(); // Calling thread only
+
+	// Background threads off the frame path (config, metrics, event and
+	// heatmap writers) exclude themselves, so checks of the frame path can
+	// read getPipelineAllocations() while they run
+	static void excludeThread();
+	static uint64_t getPipelineAllocations(); // All threads but excluded ones
+};
+} // namespace peopleDetector
@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Appearance.hpp"
+namespace peopleDetector
+{
+
+// Bin index of an RGB8 pixel, 2 bits per channel
+static inline uint8_t binIndex(const uint8_t* px) { return ((px[0] >> 6) << 4) | ((px[1] >> 6) << 2) | (px[2] >> 6); }
+
+// Quantise n RGB8 pixels into bin indices
+static void quantiseRow(const uint8_t* rgb, uint8_t* bins, int n)
+{
+	int i = 0;
+#if defined(__aarch64__)
+	const uint8x16_t mask = vdupq_n_u8(0x03);
+	for (; i + 16 <= n; i += 16) {
+		const uint8x16x3_t px = vld3q_u8(rgb + 3 * i);
+		const uint8x16_t r = vshrq_n_u8(px.val[0], 6);
+		const uint8x16_t g = vshrq_n_u8(px.val[1], 6);
+		const uint8x16_t b = vshrq_n_u8(px.val[2], 6);
+		vst1q_u8(bins + i, vorrq_u8(vorrq_u8(vshlq_n_u8(r, 4), vshlq_n_u8(g, 2)), vandq_u8(b, mask)));
+	}
+#elif defined(__SSSE3__)
+	// Deinterleave 16 RGB pixels (48 bytes) into channel vectors
+	const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+	const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+	const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+	const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+	const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+	const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+	const __m128i mask = _mm_set1_epi8(0x03);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i a = _mm_loadu_si128((const __m128i*)(rgb + 3 * i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(rgb + 3 * i + 16));
+		const __m128i c = _mm_loadu_si128((const __m128i*)(rgb + 3 * i + 32));
+		__m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(b, r1)), _mm_shuffle_epi8(c, r2));
+		__m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(b, g1)), _mm_shuffle_epi8(c, g2));
+		__m128i bl = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(b, b1)), _mm_shuffle_epi8(c, b2));
+		r = _mm_and_si128(_mm_srli_epi16(r, 6), mask);
+		g = _mm_and_si128(_mm_srli_epi16(g, 6), mask);
+		bl = _mm_and_si128(_mm_srli_epi16(bl, 6), mask);
+		_mm_storeu_si128((__m128i*)(bins + i), _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 4), _mm_slli_epi16(g, 2)), bl));
+	}
+#endif
+	for (; i < n; ++i)
+		bins[i] = binIndex(rgb + 3 * i);
+}
+
+void computeAppearance(const void* image, uint32_t width, uint32_t height, Detection& det)
+{
+	det.hasAppearance = false;
+	if (!image)
+		return;
+
+	const int x0 = std::max(0, (int)(det.Left + det.Width() * 0.25f));
+	const int x1 = std::min((int)width, (int)(det.Right - det.Width() * 0.25f));
+	const int y0 = std::max(0, (int)(det.Top + det.Height() * 0.125f));
+	const int y1 = std::min((int)height, (int)(det.Bottom - det.Height() * 0.25f));
+	const int n = x1 - x0;
+
+	if (n <= 0 || y1 <= y0)
+		return;
+
+	uint32_t counts[kAppearanceBins] = {0};
+	uint8_t bins[512];
+	uint32_t total = 0;
+
+	for (int y = y0; y < y1; y += 2) {
+		const uint8_t* row = (const uint8_t*)image + ((size_t)y * width + x0) * 3;
+		for (int x = 0; x < n; x += sizeof(bins)) {
+			const int len = std::min(n - x, (int)sizeof(bins));
+			quantiseRow(row + 3 * x, bins, len);
+			for (int i = 0; i < len; ++i)
+				++counts[bins[i]];
+			total += len;
+		}
+	}
+
+	for (int i = 0; i < kAppearanceBins; ++i)
+		det.appearance[i] = (counts[i] * 255 + total / 2) / total;
+	det.hasAppearance = true;
+}
+
+float appearanceSimilarity(const Appearance& a, const Appearance& b)
+{
+	uint32_t sum = 0;
+	int i = 0;
+#if defined(__aarch64__)
+	for (; i + 16 <= kAppearanceBins; i += 16)
+		sum += vaddlvq_u8(vminq_u8(vld1q_u8(&a[i]), vld1q_u8(&b[i])));
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= kAppearanceBins; i += 16) {
+		const __m128i m = _mm_min_epu8(_mm_loadu_si128((const __m128i*)&a[i]), _mm_loadu_si128((const __m128i*)&b[i]));
+		const __m128i s = _mm_sad_epu8(m, zero);
+		sum += _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+	}
+#endif
+	for (; i < kAppearanceBins; ++i)
+		sum += std::min(a[i], b[i]);
+	return std::min(1.0f, sum / 255.0f);
+}
+
+void blendAppearance(Appearance& track, const Appearance& det)
+{
+	for (int i = 0; i < kAppearanceBins; ++i)
+		track[i] = (3 * track[i] + det[i] + 2) >> 2;
+}
+} // namespace peopleDetector
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Compute the colour histogram of the detection's torso region (central half
+ * of the box, head and feet excluded) from an RGB8 frame and store it in
+ * det.appearance. Every second row is sampled to bound the per-box cost.
+ */
+void computeAppearance(const void* image, uint32_t width, uint32_t height, Detection& det);
+
+/**< Histogram intersection in [0, 1], 1 for identical signatures */
+float appearanceSimilarity(const Appearance& a, const Appearance& b);
+
+/**< Running average, moves track a quarter of the way towards det */
+void blendAppearance(Appearance& track, const Appearance& det);
+} // namespace peopleDetector
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Checkpoint.hpp"
+namespace peopleDetector
+{
+
+// Local day since epoch and 15 minute bucket of a system_clock time
+static void localBucket(int64_t wallTimeNs, int bucketMinutes, int32_t& day, int& bucket)
+{
+	const time_t seconds = wallTimeNs / 1000000000;
+	tm local;
+	localtime_r(&seconds, &local);
+	day = (seconds + local.tm_gmtoff) / 86400;
+	bucket = (local.tm_hour * 60 + local.tm_min) / bucketMinutes;
+}
+
+Checkpoint::Checkpoint(const std::string& path) : _path(path) { memset(&_staging, 0, sizeof(_staging)); }
+
+Checkpoint::~Checkpoint()
+{
+	if (_file)
+		munmap(_file, sizeof(CheckpointFile));
+}
+
+bool Checkpoint::open()
+{
+	const int fd = ::open(_path.c_str(), O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		LogError("Checkpoint -- failed to open %s\n", _path.c_str());
+		return false;
+	}
+	struct stat st;
+	const bool fresh = fstat(fd, &st) != 0 || st.st_size != sizeof(CheckpointFile);
+	if (fresh && ftruncate(fd, sizeof(CheckpointFile)) != 0) {
+		LogError("Checkpoint -- failed to size %s\n", _path.c_str());
+		::close(fd);
+		return false;
+	}
+	void* mem = mmap(nullptr, sizeof(CheckpointFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		LogError("Checkpoint -- failed to map %s\n", _path.c_str());
+		return false;
+	}
+
+	_file = (CheckpointFile*)mem;
+	if (fresh || _file->magic != kCheckpointMagic || _file->version != kCheckpointVersion) {
+		memset(mem, 0, sizeof(CheckpointFile));
+		_file->magic = kCheckpointMagic;
+		_file->version = kCheckpointVersion;
+	}
+	_sequence = std::max(_file->slots[0].sequence, _file->slots[1].sequence);
+	return true;
+}
+
+size_t Checkpoint::usedSize(const CheckpointPayload& payload)
+{
+	const int numTracks = payload.numTracks < 0 ? 0 : std::min(payload.numTracks, kCheckpointMaxTracks);
+	return offsetof(CheckpointPayload, tracks) + numTracks * sizeof(TrackState);
+}
+
+uint64_t Checkpoint::checksum(const CheckpointSlot& slot)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto mix = [&hash](const uint8_t* bytes, size_t n) {
+		for (size_t i = 0; i < n; ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	};
+	mix((const uint8_t*)&slot.sequence, sizeof(slot.sequence));
+	mix((const uint8_t*)&slot.payload, usedSize(slot.payload));
+	return hash;
+}
+
+bool Checkpoint::isValid(const CheckpointSlot& slot) const { return slot.sequence != 0 && slot.checksum == checksum(slot); }
+
+bool Checkpoint::restore(Counter& counter, Tracker& tracker)
+{
+	if (!_file)
+		return false;
+
+	const auto start = std::chrono::steady_clock::now();
+	const uint32_t active = _file->active.load(std::memory_order_acquire) & 1;
+	const CheckpointSlot* slot = &_file->slots[active];
+	if (!isValid(*slot)) {
+		// Torn or never written, fall back to the previous update
+		slot = &_file->slots[active ^ 1];
+		if (!isValid(*slot)) {
+			LogInfo("Checkpoint -- no valid checkpoint in %s\n", _path.c_str());
+			return false;
+		}
+	}
+	memcpy(&_staging, &slot->payload, usedSize(slot->payload));
+
+	counter.restore(_staging.status, _staging.entered, _staging.left, _staging.gateEntered, _staging.gateLeft, _staging.classIds,
+			_staging.classEntered, _staging.classLeft);
+
+	// Never hand out an id that a restored or earlier track already had
+	uint32_t nextId = _staging.nextTrackId;
+	for (int i = 0; i < _staging.numTracks; ++i)
+		nextId = std::max(nextId, (uint32_t)_staging.tracks[i].id + 1);
+	TrackedObject::setNextId(nextId);
+
+	// Positions are only useful if the restart was quick
+	const int64_t nowNs =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const int64_t ageMs = (nowNs - _staging.wallTimeNs) / 1000000;
+	const int numTracks = ageMs >= 0 && ageMs <= _maxTrackAgeMs ? _staging.numTracks : 0;
+	tracker.restoreTracks(_staging.tracks, numTracks);
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LogInfo("Checkpoint -- restored status %i, in %i, out %i and %i of %i tracks from %lli ms ago in %.2f ms\n", _staging.status,
+		_staging.entered, _staging.left, numTracks, _staging.numTracks, (long long)ageMs, ms);
+	return true;
+}
+
+void Checkpoint::update(const Counter& counter, Tracker& tracker, uint64_t frameId)
+{
+	if (!_file || ++_framesSinceUpdate < _updateInterval)
+		return;
+	_framesSinceUpdate = 0;
+
+	_staging.wallTimeNs =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	_staging.frameId = frameId;
+
+	// Attribute the crossings since the last update to the current bucket
+	int32_t day;
+	int bucket;
+	localBucket(_staging.wallTimeNs, _bucketMinutes, day, bucket);
+	if (day != _staging.day) {
+		memset(_staging.bucketEntered, 0, sizeof(_staging.bucketEntered));
+		memset(_staging.bucketLeft, 0, sizeof(_staging.bucketLeft));
+		_staging.day = day;
+	}
+	const int entered = counter.getEntered();
+	const int left = counter.getLeft();
+	_staging.bucketEntered[bucket] += entered - _staging.entered;
+	_staging.bucketLeft[bucket] += left - _staging.left;
+
+	_staging.status = counter.getStatus();
+	_staging.entered = entered;
+	_staging.left = left;
+	for (int g = 0; g < Counter::maxGates; ++g) {
+		_staging.gateEntered[g] = counter.getEntered(g);
+		_staging.gateLeft[g] = counter.getLeft(g);
+	}
+	for (int c = 0; c < Counter::maxClasses; ++c) {
+		const int classId = counter.getClassId(c);
+		_staging.classIds[c] = classId;
+		_staging.classEntered[c] = counter.getEnteredByClass(classId);
+		_staging.classLeft[c] = counter.getLeftByClass(classId);
+	}
+
+	_staging.nextTrackId = TrackedObject::getNextId();
+	_staging.numTracks = tracker.getTrackStates(_staging.tracks, kCheckpointMaxTracks);
+
+	// Write the inactive slot, then publish it
+	const uint32_t target = (_file->active.load(std::memory_order_relaxed) & 1) ^ 1;
+	CheckpointSlot& slot = _file->slots[target];
+	memcpy(&slot.payload, &_staging, usedSize(_staging));
+	slot.sequence = ++_sequence;
+	slot.checksum = checksum(slot);
+	_file->active.store(target, std::memory_order_release);
+}
+} // namespace peopleDetector
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Counter.hpp"
+#include "TrackedObject.hpp"
+#include "Tracker.hpp"
+
+namespace peopleDetector
+{
+
+static const uint32_t kCheckpointMagic = 0x50434b50; // "PCKP"
+static const uint32_t kCheckpointVersion = 3;
+static const int kCheckpointMaxTracks = 64;
+static const int kCheckpointBuckets = 96; // 15 minute buckets of one day
+
+struct CheckpointPayload {
+	int64_t wallTimeNs; // system_clock time of the update
+	uint64_t frameId;
+
+	int32_t status;
+	int32_t entered;
+	int32_t left;
+	int32_t gateEntered[Counter::maxGates];
+	int32_t gateLeft[Counter::maxGates];
+	int32_t classIds[Counter::maxClasses]; // Class of each tally, -1 if unused
+	int32_t classEntered[Counter::maxClasses];
+	int32_t classLeft[Counter::maxClasses];
+
+	int32_t day; // Local day (since epoch) the buckets belong to
+	int32_t bucketEntered[kCheckpointBuckets];
+	int32_t bucketLeft[kCheckpointBuckets];
+
+	uint32_t nextTrackId;
+	int32_t numTracks;
+	TrackState tracks[kCheckpointMaxTracks]; // Only numTracks are written
+};
+
+struct CheckpointSlot {
+	uint64_t sequence; // 0 = never written
+	uint64_t checksum; // FNV-1a over sequence and the used part of payload
+	CheckpointPayload payload;
+};
+
+// File layout. Updates go to the inactive slot, which is then published by
+// flipping active, so a crash mid-update leaves the previous slot intact.
+struct CheckpointFile {
+	uint32_t magic;
+	uint32_t version;
+	std::atomic<uint32_t> active;
+	CheckpointSlot slots[2];
+};
+
+/**
+ * Warm-restart checkpoint of the counters, per-day time buckets, the
+ * confirmed tracks' filter states and the track id allocator, kept in a
+ * memory-mapped file. update() is called from the frame loop and only
+ * copies a few kB into the page cache; the kernel writes it back.
+ */
+class Checkpoint
+{
+      public:
+	// ################### Settings ###################
+	const int _updateInterval = 5;	     // Frames between updates
+	const int64_t _maxTrackAgeMs = 5000; // Older checkpoints restore the counts only
+	const int _bucketMinutes = 24 * 60 / kCheckpointBuckets;
+	// ################################################
+
+	Checkpoint(const std::string& path);
+	~Checkpoint();
+
+	bool open();
+	bool restore(Counter& counter, Tracker& tracker); // True if a valid checkpoint was applied
+	void update(const Counter& counter, Tracker& tracker, uint64_t frameId);
+
+	inline const CheckpointPayload& getLast() const { return _staging; }
+
+      private:
+	static size_t usedSize(const CheckpointPayload& payload);
+	static uint64_t checksum(const CheckpointSlot& slot);
+	bool isValid(const CheckpointSlot& slot) const;
+
+	std::string _path;
+	CheckpointFile* _file = nullptr;
+	uint64_t _sequence = 0;
+	int _framesSinceUpdate = 0;
+	CheckpointPayload _staging; // Filled outside the mapped file
+};
+} // namespace peopleDetector
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <logging.h>
+
+#include "ClassMask.hpp"
+namespace peopleDetector
+{
+
+ClassMask::ClassMask()
+{
+	memset(_slots, -1, sizeof(_slots));
+	memset(_classIds, 0, sizeof(_classIds));
+}
+
+bool ClassMask::compile(const std::string& selection, const std::vector<std::string>& labels)
+{
+	memset(_slots, -1, sizeof(_slots));
+	_count = 0;
+
+	size_t begin = 0;
+	while (begin <= selection.size()) {
+		size_t end = selection.find(',', begin);
+		if (end == std::string::npos)
+			end = selection.size();
+
+		std::string name = selection.substr(begin, end - begin);
+		name.erase(0, name.find_first_not_of(" \t"));
+		name.erase(name.find_last_not_of(" \t") + 1);
+		begin = end + 1;
+		if (name.empty())
+			continue;
+
+		// Numeric ids select directly, names match the loaded labels
+		char* numberEnd = nullptr;
+		long classId = strtol(name.c_str(), &numberEnd, 10);
+		if (*numberEnd != '\0') {
+			classId = -1;
+			for (size_t i = 0; i < labels.size(); ++i) {
+				if (labels[i] == name) {
+					classId = i;
+					break;
+				}
+			}
+		}
+
+		const long numClasses = labels.empty() ? kMaxClassIds : std::min<long>(labels.size(), kMaxClassIds);
+		if (classId < 0 || classId >= numClasses || (!labels.empty() && labels[classId] == "void")) {
+			LogError("ClassMask -- unknown class '%s'\n", name.c_str());
+			continue;
+		}
+		if (_slots[classId] >= 0)
+			continue;
+		if (_count >= kMaxCountedClasses) {
+			LogError("ClassMask -- more than %i classes selected, ignoring '%s'\n", kMaxCountedClasses, name.c_str());
+			continue;
+		}
+		_slots[classId] = _count;
+		_classIds[_count] = classId;
+		++_count;
+	}
+	return _count > 0;
+}
+} // namespace peopleDetector
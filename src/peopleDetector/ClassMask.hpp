@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Counter.hpp"
+
+namespace peopleDetector
+{
+
+static const int kMaxClassIds = 256;	 // Class ids the table covers
+static const int kMaxCountedClasses = Counter::maxClasses; // Classes with their own tallies
+
+/**
+ * Lookup table from detector class id to its slot in the selection, compiled
+ * once from a comma separated selection of labels (or numeric ids), e.g.
+ * "person,bicycle".
+ * Filtering a detection is then a single table lookup; ids without a slot,
+ * including "void" labels, are dropped.
+ */
+class ClassMask
+{
+      public:
+	ClassMask();
+
+	/**< Build the table from selection against the loaded labels, false if nothing was selected */
+	bool compile(const std::string& selection, const std::vector<std::string>& labels);
+
+	/**< Slot of classId in the selection, -1 if the class is not counted */
+	inline int slot(uint32_t classId) const { return classId < kMaxClassIds ? _slots[classId] : -1; }
+
+	inline int size() const { return _count; }
+	inline uint32_t getClassId(int slot) const { return _classIds[slot]; }
+
+      private:
+	int8_t _slots[kMaxClassIds];
+	uint32_t _classIds[kMaxCountedClasses];
+	int _count = 0;
+};
+} // namespace peopleDetector
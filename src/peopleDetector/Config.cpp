@@ -0,0 +1,307 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <logging.h>
+#include <sys/stat.h>
+
+#include "AllocTracker.hpp"
+#include "Config.hpp"
+#include "ThreadPolicy.hpp"
+namespace peopleDetector
+{
+
+static const Config defaultConfig;
+static std::atomic<const Config*> publishedConfig{&defaultConfig};
+static thread_local const Config* threadConfig = nullptr; // ScopedConfig override
+
+const Config& currentConfig()
+{
+	if (threadConfig)
+		return *threadConfig;
+	return *publishedConfig.load(std::memory_order_acquire);
+}
+
+ScopedConfig::ScopedConfig(const Config& config) : _previous(threadConfig) { threadConfig = &config; }
+
+ScopedConfig::~ScopedConfig() { threadConfig = _previous; }
+
+static int64_t modifiedNs(const std::string& path)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return -1;
+	return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+static int64_t nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static char* trim(char* s)
+{
+	while (*s == ' ' || *s == '\t')
+		++s;
+	char* end = s + strlen(s);
+	while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+		--end;
+	*end = '\0';
+	return s;
+}
+
+// "x, x, ..." into config.gateLineX
+static bool parseGateLines(const std::string& text, Config& config)
+{
+	config.numGateLines = 0;
+	const char* p = text.c_str();
+	while (*p) {
+		char* end = nullptr;
+		const float x = strtof(p, &end);
+		if (end == p || config.numGateLines == Config::maxGateLines)
+			return false;
+		config.gateLineX[config.numGateLines++] = x;
+		p = end;
+		while (*p == ' ' || *p == '\t')
+			++p;
+		if (*p == ',')
+			++p;
+		else if (*p)
+			return false;
+	}
+	return true;
+}
+
+// "left top right bottom; ..." into config.zone
+static bool parseZones(const std::string& text, Config& config)
+{
+	config.numZones = 0;
+	const char* p = text.c_str();
+	while (*p) {
+		ZoneRect zone;
+		int consumed = 0;
+		if (config.numZones == Config::maxZones ||
+		    sscanf(p, " %f %f %f %f %n", &zone.left, &zone.top, &zone.right, &zone.bottom, &consumed) != 4 || zone.right <= zone.left ||
+		    zone.bottom <= zone.top)
+			return false;
+		config.zone[config.numZones++] = zone;
+		p += consumed;
+		if (*p == ';')
+			++p;
+		else if (*p)
+			return false;
+	}
+	return true;
+}
+
+bool parseConfig(const std::string& path, Config& out)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (!file)
+		return false;
+
+	Config config;
+	struct Field {
+		const char* key;
+		float* f;
+		int* i;
+		std::string* s;
+	};
+	const Field fields[] = {
+	    {"coverageThreshold", &config.coverageThreshold, nullptr, nullptr},
+	    {"countedClasses", nullptr, nullptr, &config.countedClasses},
+	    {"associationDistanceThreshold", &config.associationDistanceThreshold, nullptr, nullptr},
+	    {"gateChiSquare", &config.gateChiSquare, nullptr, nullptr},
+	    {"appearanceWeight", &config.appearanceWeight, nullptr, nullptr},
+	    {"maxCoastCount", nullptr, &config.maxCoastCount, nullptr},
+	    {"initialErrorCovariance", &config.initialErrorCovariance, nullptr, nullptr},
+	    {"processVariance", &config.processVariance, nullptr, nullptr},
+	    {"measurementVariance", &config.measurementVariance, nullptr, nullptr},
+	    {"incomerLineX", &config.incomerLineX, nullptr, nullptr},
+	    {"countingLineX", &config.countingLineX, nullptr, nullptr},
+	    {"gateLines", nullptr, nullptr, &config.gateLines},
+	    {"zones", nullptr, nullptr, &config.zones},
+	    {"latencyBudgetMs", &config.latencyBudgetMs, nullptr, nullptr},
+	    {"captureCpus", nullptr, nullptr, &config.captureCpus},
+	    {"detectCpus", nullptr, nullptr, &config.detectCpus},
+	    {"trackCpus", nullptr, nullptr, &config.trackCpus},
+	    {"outputCpus", nullptr, nullptr, &config.outputCpus},
+	    {"capturePriority", nullptr, &config.capturePriority, nullptr},
+	    {"detectPriority", nullptr, &config.detectPriority, nullptr},
+	    {"trackPriority", nullptr, &config.trackPriority, nullptr},
+	    {"outputPriority", nullptr, &config.outputPriority, nullptr},
+	};
+
+	bool ok = true;
+	char line[256];
+	int lineNumber = 0;
+	while (fgets(line, sizeof(line), file)) {
+		++lineNumber;
+		if (!strchr(line, '\n') && !feof(file)) {
+			// The rest would be read as a line of its own
+			LogError("Config -- %s:%i: line longer than %zu characters\n", path.c_str(), lineNumber, sizeof(line) - 2);
+			ok = false;
+			int c;
+			while ((c = fgetc(file)) != EOF && c != '\n')
+				;
+			continue;
+		}
+		if (char* comment = strchr(line, '#'))
+			*comment = '\0';
+		char* key = trim(line);
+		if (!*key)
+			continue;
+
+		char* eq = strchr(key, '=');
+		if (!eq) {
+			LogError("Config -- %s:%i: expected key = value\n", path.c_str(), lineNumber);
+			ok = false;
+			continue;
+		}
+		*eq = '\0';
+		key = trim(key);
+		const char* value = trim(eq + 1);
+
+		const Field* field = nullptr;
+		for (const Field& f : fields) {
+			if (strcmp(f.key, key) == 0)
+				field = &f;
+		}
+		if (!field) {
+			LogError("Config -- %s:%i: unknown key '%s'\n", path.c_str(), lineNumber, key);
+			ok = false;
+			continue;
+		}
+
+		if (field->s) {
+			*field->s = value;
+			continue;
+		}
+
+		char* end = nullptr;
+		if (field->f)
+			*field->f = strtof(value, &end);
+		else
+			*field->i = strtol(value, &end, 10);
+		if (end == value || *end != '\0') {
+			LogError("Config -- %s:%i: invalid value '%s' for %s\n", path.c_str(), lineNumber, value, key);
+			ok = false;
+		}
+	}
+	fclose(file);
+
+	if (config.coverageThreshold > 1 || config.associationDistanceThreshold <= 0 || config.gateChiSquare <= 0 ||
+	    config.appearanceWeight < 0 || config.appearanceWeight > 1 || config.maxCoastCount < 0 || config.processVariance <= 0 ||
+	    config.measurementVariance <= 0 || config.latencyBudgetMs <= 0) {
+		LogError("Config -- %s: value out of range\n", path.c_str());
+		ok = false;
+	}
+	if (!parseGateLines(config.gateLines, config)) {
+		LogError("Config -- %s: gateLines must be up to %i x positions separated by commas\n", path.c_str(), Config::maxGateLines);
+		ok = false;
+	}
+	if (!parseZones(config.zones, config)) {
+		LogError("Config -- %s: zones must be up to %i 'left top right bottom' rectangles separated by ';'\n", path.c_str(),
+			 Config::maxZones);
+		ok = false;
+	}
+	for (const std::string* cpus : {&config.captureCpus, &config.detectCpus, &config.trackCpus, &config.outputCpus}) {
+		if (!cpus->empty() && !isValidCpuList(*cpus)) {
+			LogError("Config -- %s: invalid CPU list '%s', expected e.g. \"0-1,3\" of CPUs this process may use\n", path.c_str(),
+				 cpus->c_str());
+			ok = false;
+		}
+	}
+	for (int priority : {config.capturePriority, config.detectPriority, config.trackPriority, config.outputPriority}) {
+		if (priority < 0 || priority > 99) {
+			LogError("Config -- %s: thread priorities must be 0 (default policy) to 99\n", path.c_str());
+			ok = false;
+			break;
+		}
+	}
+
+	if (ok)
+		out = config;
+	return ok;
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path) : _path(path) {}
+
+ConfigWatcher::~ConfigWatcher()
+{
+	stop();
+	// Detached readers (track threads) may still hold the last snapshots
+	// at shutdown, leave those to the process exit
+	_current.release();
+	for (auto& retired : _retired)
+		retired.config.release();
+}
+
+bool ConfigWatcher::reload()
+{
+	_mtimeNs = modifiedNs(_path);
+	if (_mtimeNs < 0)
+		return false;
+
+	std::unique_ptr<Config> config(new Config);
+	if (!parseConfig(_path, *config)) {
+		LogError("Config -- keeping the current configuration, %s is invalid\n", _path.c_str());
+		return false;
+	}
+	publish(std::move(config));
+	LogInfo("Config -- loaded %s\n", _path.c_str());
+	return true;
+}
+
+void ConfigWatcher::publish(std::unique_ptr<Config> config)
+{
+	publishedConfig.store(config.get(), std::memory_order_release);
+	if (_current)
+		_retired.push_back({nowMs(), std::move(_current)});
+	_current = std::move(config);
+}
+
+void ConfigWatcher::reclaim()
+{
+	const int64_t now = nowMs();
+	size_t kept = 0;
+	for (size_t i = 0; i < _retired.size(); ++i) {
+		if (now - _retired[i].retiredMs < _gracePeriodMs)
+			_retired[kept++] = std::move(_retired[i]);
+	}
+	_retired.resize(kept);
+}
+
+void ConfigWatcher::start()
+{
+	if (_thread.joinable())
+		return;
+	if (modifiedNs(_path) < 0)
+		LogInfo("Config -- %s not found, using the defaults until it appears\n", _path.c_str());
+	else
+		reload();
+	_stop = false;
+	_thread = std::thread(&ConfigWatcher::run, this);
+}
+
+void ConfigWatcher::stop()
+{
+	_stop = true;
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void ConfigWatcher::run()
+{
+	ScopedThreadRole role(ThreadRole::OUTPUT, "config");
+	AllocTracker::excludeThread();
+	while (!_stop) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(_pollIntervalMs));
+
+		const int64_t mtime = modifiedNs(_path);
+		if (mtime >= 0 && mtime != _mtimeNs)
+			reload();
+		reclaim();
+	}
+}
+} // namespace peopleDetector
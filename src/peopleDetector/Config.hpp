@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace peopleDetector
+{
+
+struct ZoneRect {
+	float left, top, right, bottom;
+};
+
+/**
+ * Tunable thresholds. A published Config is immutable; readers get the
+ * current snapshot with currentConfig() (a single acquire load) and must not
+ * keep the reference across frames.
+ */
+struct Config {
+	// PeopleDetector
+	float coverageThreshold = -1.0f;	   // Detection confidence threshold, < 0 keeps the network default
+	std::string countedClasses = "person"; // Comma separated labels or class ids, see ClassMask
+
+	// Tracker
+	float associationDistanceThreshold = 100.0f; // Hard cap, and the gate of tracks without a prediction
+	float gateChiSquare = 9.21f;		      // 99% bound of chi-square with 2 degrees of freedom
+	float appearanceWeight = 0.3f;		      // Share of appearance in the association cost
+
+	// TrackedObject
+	int maxCoastCount = 20;
+	float initialErrorCovariance = 1.0f;
+	float processVariance = 1.0f;
+	float measurementVariance = 25.0f; // ~5 px jitter of the box centre
+
+	// Counting geometry (pixels)
+	float incomerLineX = 400.0f;  // Tracks first seen left of this are incomers
+	float countingLineX = 640.0f; // Crossing this line counts, gate 0
+	std::string gateLines;	      // Further vertical lines "x, x, ..." as gates 1.., tallied per gate only
+	std::string zones;	      // Occupancy zones "left top right bottom; ..." as zones 1.., zone 0 is behind the counting line
+
+	// Parsed from gateLines and zones by parseConfig
+	static const int maxGateLines = 7; // Counter::maxGates - 1
+	static const int maxZones = 7;	   // kSharedMaxZones - 1
+	int numGateLines = 0;
+	float gateLineX[maxGateLines] = {};
+	int numZones = 0;
+	ZoneRect zone[maxZones] = {};
+
+	// LoadShedder
+	float latencyBudgetMs = 200.0f; // Maximum capture-to-count age before shedding work
+
+	// Thread placement per pipeline stage (ThreadPolicy.hpp), applied when a
+	// thread starts. CPU lists like "0-1,3", empty leaves the thread
+	// unpinned; a priority of 1-99 selects SCHED_FIFO, 0 the default policy.
+	std::string captureCpus;
+	std::string detectCpus;
+	std::string trackCpus;
+	std::string outputCpus;
+	int capturePriority = 0;
+	int detectPriority = 0;
+	int trackPriority = 0;
+	int outputPriority = 0;
+};
+
+/**< Current snapshot, valid for at least the reload grace period */
+const Config& currentConfig();
+
+/**
+ * Makes currentConfig() return config on the calling thread only, until
+ * destroyed. Lets one thread step synchronous trackers with different
+ * settings side by side (PeopleCounterReplay); track threads of
+ * asynchronous trackers keep reading the published snapshot.
+ */
+class ScopedConfig
+{
+      public:
+	explicit ScopedConfig(const Config& config);
+	~ScopedConfig();
+
+      private:
+	const Config* _previous;
+};
+
+/**< Parse "key = value" lines ('#' starts a comment), missing keys keep their defaults */
+bool parseConfig(const std::string& path, Config& out);
+
+/**
+ * Loads the config file and publishes it, then polls the file for changes on
+ * its own thread and publishes each valid revision with one atomic pointer
+ * swap. A file that fails to parse leaves the current snapshot in place.
+ * Replaced snapshots are freed only after a grace period, so readers never
+ * take a lock or a reference count.
+ */
+class ConfigWatcher
+{
+      public:
+	// ################### Settings ###################
+	const int _pollIntervalMs = 1000;
+	const int _gracePeriodMs = 10000; // Lifetime of a replaced snapshot
+	// ################################################
+
+	ConfigWatcher(const std::string& path);
+	~ConfigWatcher();
+
+	bool reload(); // Parse and publish now, returns false if the file is unusable
+	void start();
+	void stop();
+
+      private:
+	void run();
+	void publish(std::unique_ptr<Config> config);
+	void reclaim();
+
+	struct Retired {
+		int64_t retiredMs;
+		std::unique_ptr<Config> config;
+	};
+
+	std::string _path;
+	int64_t _mtimeNs = 0;
+	std::vector<Retired> _retired;
+	std::unique_ptr<Config> _current;
+
+	std::thread _thread;
+	std::atomic<bool> _stop{false};
+};
+} // namespace peopleDetector
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fcntl.h>
+#include <logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CountArchive.hpp"
+namespace peopleDetector
+{
+
+static const size_t kHeaderSize = offsetof(CountArchiveFile, records);
+
+static size_t fileSize(size_t capacity) { return kHeaderSize + capacity * sizeof(CountArchiveRecord); }
+
+// Interval of a wall time, rounding down for times before the epoch too
+static int64_t intervalOf(int64_t wallTimeNs, uint32_t resolutionSeconds)
+{
+	const int64_t resolutionNs = (int64_t)resolutionSeconds * 1000000000;
+	return wallTimeNs >= 0 ? wallTimeNs / resolutionNs : -((-wallTimeNs + resolutionNs - 1) / resolutionNs);
+}
+
+CountArchive::CountArchive(const std::string& path) : _path(path) {}
+
+CountArchive::~CountArchive() { close(); }
+
+bool CountArchive::open(bool writable)
+{
+	close();
+	_writable = writable;
+	_fd = ::open(_path.c_str(), writable ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+	if (_fd < 0) {
+		LogError("CountArchive -- failed to open %s\n", _path.c_str());
+		return false;
+	}
+	struct stat st;
+	if (fstat(_fd, &st) != 0) {
+		close();
+		return false;
+	}
+
+	const bool fresh = (size_t)st.st_size < kHeaderSize;
+	if (fresh && !writable) {
+		LogError("CountArchive -- %s is empty\n", _path.c_str());
+		close();
+		return false;
+	}
+	if (fresh && ftruncate(_fd, fileSize(_growRecords)) != 0) {
+		LogError("CountArchive -- failed to size %s\n", _path.c_str());
+		close();
+		return false;
+	}
+	const size_t capacity = fresh ? _growRecords : (st.st_size - kHeaderSize) / sizeof(CountArchiveRecord);
+	if (!map(capacity)) {
+		close();
+		return false;
+	}
+
+	if (fresh) {
+		_file->magic = kCountArchiveMagic;
+		_file->version = kCountArchiveVersion;
+		_file->resolutionSeconds = _resolutionSeconds;
+		_file->numRecords.store(0, std::memory_order_release);
+	} else if (_file->magic != kCountArchiveMagic || _file->version != kCountArchiveVersion || _file->resolutionSeconds == 0) {
+		// Unlike a checkpoint, history is not thrown away
+		LogError("CountArchive -- %s is not a count archive (version %u)\n", _path.c_str(), kCountArchiveVersion);
+		close();
+		return false;
+	}
+
+	_index.clear();
+	refreshIndex(getRecordCount());
+	LogInfo("CountArchive -- %s: %llu records at %u s resolution\n", _path.c_str(), (unsigned long long)getRecordCount(),
+		_file->resolutionSeconds);
+	return true;
+}
+
+void CountArchive::close()
+{
+	if (_file)
+		munmap(_file, fileSize(_capacity));
+	if (_fd >= 0)
+		::close(_fd);
+	_file = nullptr;
+	_fd = -1;
+	_capacity = 0;
+	_index.clear();
+	_hasLast = false;
+}
+
+bool CountArchive::map(size_t capacity)
+{
+	if (_file)
+		munmap(_file, fileSize(_capacity));
+	_file = nullptr;
+	_capacity = 0;
+
+	void* mem = mmap(nullptr, fileSize(capacity), _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _fd, 0);
+	if (mem == MAP_FAILED) {
+		LogError("CountArchive -- failed to map %s\n", _path.c_str());
+		return false;
+	}
+	_file = (CountArchiveFile*)mem;
+	_capacity = capacity;
+	return true;
+}
+
+uint64_t CountArchive::getRecordCount() const
+{
+	return _file ? std::min<uint64_t>(_file->numRecords.load(std::memory_order_acquire), _capacity) : 0;
+}
+
+int64_t CountArchive::getFirstTimeNs() const
+{
+	return getRecordCount() ? _file->records[0].interval * _file->resolutionSeconds * 1000000000 : 0;
+}
+
+int64_t CountArchive::getLastTimeNs() const
+{
+	const uint64_t n = getRecordCount();
+	return n ? _file->records[n - 1].interval * _file->resolutionSeconds * 1000000000 : 0;
+}
+
+void CountArchive::refreshIndex(uint64_t numRecords)
+{
+	for (size_t i = _index.size() * _indexStride; i < numRecords; i += _indexStride)
+		_index.push_back(_file->records[i].interval);
+}
+
+void CountArchive::update(const Counter& counter)
+{
+	const int64_t nowNs =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	record(nowNs, counter.getEntered(), counter.getLeft());
+}
+
+void CountArchive::record(int64_t wallTimeNs, uint64_t entered, uint64_t left)
+{
+	if (!_file || !_writable)
+		return;
+
+	// The first totals after open() are the baseline, e.g. a restored
+	// checkpoint whose crossings are already archived
+	if (!_hasLast) {
+		_hasLast = true;
+		_lastEntered = entered;
+		_lastLeft = left;
+		return;
+	}
+	const uint64_t deltaEntered = entered > _lastEntered ? entered - _lastEntered : 0;
+	const uint64_t deltaLeft = left > _lastLeft ? left - _lastLeft : 0;
+	_lastEntered = entered;
+	_lastLeft = left;
+	if (deltaEntered == 0 && deltaLeft == 0)
+		return;
+
+	const int64_t interval = intervalOf(wallTimeNs, _file->resolutionSeconds);
+	const uint64_t n = _file->numRecords.load(std::memory_order_relaxed);
+	if (n > 0 && _file->records[n - 1].interval >= interval) {
+		// Same interval (or the clock stepped back): extend the last record
+		_file->records[n - 1].entered += deltaEntered;
+		_file->records[n - 1].left += deltaLeft;
+		return;
+	}
+
+	if (n >= _capacity) {
+		const size_t capacity = _capacity + _growRecords;
+		if (ftruncate(_fd, fileSize(capacity)) != 0 || !map(capacity)) {
+			LogError("CountArchive -- failed to grow %s, crossings are not archived\n", _path.c_str());
+			return;
+		}
+	}
+
+	CountArchiveRecord& record = _file->records[n];
+	record.interval = interval;
+	record.entered = (n > 0 ? _file->records[n - 1].entered : 0) + deltaEntered;
+	record.left = (n > 0 ? _file->records[n - 1].left : 0) + deltaLeft;
+	_file->numRecords.store(n + 1, std::memory_order_release);
+	refreshIndex(n + 1);
+}
+
+const CountArchiveRecord* CountArchive::before(int64_t interval, uint64_t numRecords) const
+{
+	// Index entries below interval, the last of them starts the block to search
+	const size_t block = std::lower_bound(_index.begin(), _index.end(), interval) - _index.begin();
+	if (block == 0)
+		return nullptr;
+	const CountArchiveRecord* first = _file->records + (block - 1) * _indexStride;
+	const CountArchiveRecord* last = _file->records + std::min<uint64_t>(block * _indexStride, numRecords);
+	const CountArchiveRecord* found =
+	    std::lower_bound(first, last, interval, [](const CountArchiveRecord& r, int64_t value) { return r.interval < value; });
+	return found - 1;
+}
+
+bool CountArchive::query(int64_t fromNs, int64_t toNs, uint64_t& entered, uint64_t& left)
+{
+	entered = 0;
+	left = 0;
+	if (!_file)
+		return false;
+
+	// A read-only archive may have been grown by the writing process
+	uint64_t n = _file->numRecords.load(std::memory_order_acquire);
+	if (n > _capacity) {
+		struct stat st;
+		if (fstat(_fd, &st) != 0 || !map((st.st_size - kHeaderSize) / sizeof(CountArchiveRecord)))
+			return false;
+		n = std::min<uint64_t>(n, _capacity);
+	}
+	refreshIndex(n);
+	if (toNs <= fromNs)
+		return true;
+
+	const CountArchiveRecord* from = before(intervalOf(fromNs, _file->resolutionSeconds), n);
+	const CountArchiveRecord* to = before(intervalOf(toNs, _file->resolutionSeconds), n);
+	if (to) {
+		entered = to->entered - (from ? from->entered : 0);
+		left = to->left - (from ? from->left : 0);
+	}
+	return true;
+}
+} // namespace peopleDetector
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Counter.hpp"
+
+namespace peopleDetector
+{
+
+static const uint32_t kCountArchiveMagic = 0x41434350; // "PCCA"
+static const uint32_t kCountArchiveVersion = 1;
+
+// One interval with crossings. Totals are prefix sums over the whole
+// archive up to and including this interval; quiet intervals have no record.
+struct CountArchiveRecord {
+	int64_t interval; // Unix time / resolutionSeconds
+	uint64_t entered;
+	uint64_t left;
+};
+
+// File layout: the header, then numRecords records ordered by interval.
+// The file is grown in chunks, records past numRecords are unused.
+struct CountArchiveFile {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t resolutionSeconds;
+	uint32_t reserved;
+	std::atomic<uint64_t> numRecords; // Published after the record is written
+	uint8_t padding[40];
+	CountArchiveRecord records[1];
+};
+
+/**
+ * Append-only time series of the in/out counts at a fixed resolution, kept
+ * in a memory-mapped file. The frame loop calls update() every frame; it
+ * only writes when the totals changed, overwriting the record of the
+ * current interval or appending the next one. Range queries subtract two
+ * prefix sums found by binary search, narrowed first by an in-memory index
+ * of every _indexStride-th interval, so they cost O(log n) record reads
+ * straight from the mapping however long the archive grows.
+ */
+class CountArchive
+{
+      public:
+	// ################### Settings ###################
+	const uint32_t _resolutionSeconds = 60; // Granularity of stored counts and of queries
+	const size_t _growRecords = 1 << 16;	// File growth step (1.5 MB)
+	const size_t _indexStride = 256;	// Records per in-memory index entry
+	// ################################################
+
+	CountArchive(const std::string& path);
+	~CountArchive();
+
+	bool open(bool writable = true);
+	void close();
+
+	/**< Record the counter's totals at the current wall time */
+	void update(const Counter& counter);
+	/**< Record totals seen at wallTimeNs; decreases (counter resets) are not subtracted */
+	void record(int64_t wallTimeNs, uint64_t entered, uint64_t left);
+
+	/**
+	 * Crossings in the intervals starting in [fromNs, toNs), both rounded
+	 * down to the resolution. Returns false if the archive is not open.
+	 */
+	bool query(int64_t fromNs, int64_t toNs, uint64_t& entered, uint64_t& left);
+
+	uint64_t getRecordCount() const;
+	inline uint32_t getResolutionSeconds() const { return _file ? _file->resolutionSeconds : _resolutionSeconds; }
+	int64_t getFirstTimeNs() const; // Start of the first recorded interval, 0 if empty
+	int64_t getLastTimeNs() const;	// Start of the last recorded interval, 0 if empty
+
+      private:
+	bool map(size_t capacity);
+	void refreshIndex(uint64_t numRecords);
+	const CountArchiveRecord* before(int64_t interval, uint64_t numRecords) const; // Last record < interval
+
+	std::string _path;
+	int _fd = -1;
+	bool _writable = false;
+	CountArchiveFile* _file = nullptr;
+	size_t _capacity = 0; // Records the mapping holds
+	std::vector<int64_t> _index; // interval of records 0, _indexStride, 2 * _indexStride ...
+
+	// Totals last seen from the counter, its deltas are added to the archive
+	bool _hasLast = false;
+	uint64_t _lastEntered = 0;
+	uint64_t _lastLeft = 0;
+};
+} // namespace peopleDetector
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <logging.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "CountPublisher.hpp"
+namespace peopleDetector
+{
+
+CountPublisher::CountPublisher(const std::string& name) : _name(name) { memset(&_staging, 0, sizeof(_staging)); }
+
+CountPublisher::~CountPublisher()
+{
+	if (_segment)
+		munmap(_segment, sizeof(SharedCountsSegment));
+}
+
+bool CountPublisher::open()
+{
+	const int fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		LogError("CountPublisher -- shm_open(%s) failed\n", _name.c_str());
+		return false;
+	}
+	if (ftruncate(fd, sizeof(SharedCountsSegment)) != 0) {
+		LogError("CountPublisher -- failed to size %s\n", _name.c_str());
+		close(fd);
+		return false;
+	}
+	void* mem = mmap(nullptr, sizeof(SharedCountsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		LogError("CountPublisher -- failed to map %s\n", _name.c_str());
+		return false;
+	}
+
+	_segment = (SharedCountsSegment*)mem;
+	// The sequence of a previous run stays as it is, so readers that kept
+	// the segment mapped across a restart never see it go back. If that run
+	// died mid-write it is odd and readers retry until the first publish.
+	_segment->magic = kSharedCountsMagic;
+	_segment->version = kSharedCountsVersion;
+	std::atomic_thread_fence(std::memory_order_release);
+	return true;
+}
+
+void CountPublisher::publish(const SharedCounts& counts)
+{
+	if (!_segment)
+		return;
+
+	// Odd while writing; already odd after an interrupted write
+	const uint32_t seq = _segment->sequence.load(std::memory_order_relaxed) | 1;
+	_segment->sequence.store(seq, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&_segment->data, &counts, sizeof(SharedCounts));
+	_segment->sequence.store(seq + 1, std::memory_order_release);
+}
+
+void CountPublisher::publish(const Counter& counter, uint64_t frameId, int numGates, const int* zoneOccupancy, int numZones)
+{
+	_staging.timestampNs =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	_staging.frameId = frameId;
+	_staging.status = counter.getStatus();
+	_staging.entered = counter.getEntered();
+	_staging.left = counter.getLeft();
+
+	_staging.numGates = std::min(std::max(numGates, 1), std::min((int)Counter::maxGates, (int)kSharedMaxGates));
+	for (uint32_t g = 0; g < _staging.numGates; ++g) {
+		_staging.gates[g].entered = counter.getEntered(g);
+		_staging.gates[g].left = counter.getLeft(g);
+	}
+
+	// Zone 0 is the area behind the counting line, the configured zones follow
+	_staging.numZones = 1 + std::min(numZones, kSharedMaxZones - 1);
+	_staging.zones[0].occupancy = _staging.status;
+	for (uint32_t z = 1; z < _staging.numZones; ++z)
+		_staging.zones[z].occupancy = zoneOccupancy[z - 1];
+
+	publish(_staging);
+}
+} // namespace peopleDetector
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "Counter.hpp"
+#include "SharedCounts.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Single writer of the shared-memory count segment. Call publish() from one
+ * thread only (the frame loop); readers use CountReader.
+ */
+class CountPublisher
+{
+      public:
+	CountPublisher(const std::string& name = PEOPLECOUNTER_SHM_NAME);
+	~CountPublisher();
+
+	bool open();
+	void publish(const SharedCounts& counts);
+	// Gates 0..numGates-1 from counter; zones 1..numZones from zoneOccupancy
+	void publish(const Counter& counter, uint64_t frameId, int numGates = 1, const int* zoneOccupancy = nullptr, int numZones = 0);
+
+      private:
+	std::string _name;
+	SharedCountsSegment* _segment = nullptr;
+	SharedCounts _staging; // Filled outside the write window
+};
+} // namespace peopleDetector
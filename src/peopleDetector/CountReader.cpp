@@ -0,0 +1,61 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CountReader.hpp"
+namespace peopleDetector
+{
+
+CountReader::CountReader(const std::string& name) : _name(name) {}
+
+CountReader::~CountReader()
+{
+	if (_segment)
+		munmap((void*)_segment, sizeof(SharedCountsSegment));
+}
+
+bool CountReader::open()
+{
+	const int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SharedCountsSegment)) {
+		close(fd);
+		return false;
+	}
+	void* mem = mmap(nullptr, sizeof(SharedCountsSegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		return false;
+
+	const SharedCountsSegment* segment = (const SharedCountsSegment*)mem;
+	if (segment->magic != kSharedCountsMagic || segment->version != kSharedCountsVersion) {
+		munmap(mem, sizeof(SharedCountsSegment));
+		return false;
+	}
+	_segment = segment;
+	return true;
+}
+
+bool CountReader::snapshot(SharedCounts& out, int maxRetries) const
+{
+	if (!_segment)
+		return false;
+
+	for (int i = 0; i < maxRetries; ++i) {
+		const uint32_t before = _segment->sequence.load(std::memory_order_acquire);
+		if (before & 1)
+			continue; // writer in progress
+		memcpy(&out, (const void*)&_segment->data, sizeof(SharedCounts));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint32_t after = _segment->sequence.load(std::memory_order_relaxed);
+		if (before == after)
+			return true;
+	}
+	return false;
+}
+} // namespace peopleDetector
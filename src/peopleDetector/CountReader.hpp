@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "SharedCounts.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Reader side of the shared-memory count segment, for signage / BMS
+ * processes on the same host. Has no dependencies beyond libc/librt; once
+ * opened, snapshot() is a plain memory read without syscalls and never
+ * blocks the writer.
+ */
+class CountReader
+{
+      public:
+	CountReader(const std::string& name = PEOPLECOUNTER_SHM_NAME);
+	~CountReader();
+
+	bool open();
+
+	/**
+	 * Copy a consistent snapshot into out. Returns false if the segment is
+	 * not open or no consistent copy was obtained within maxRetries.
+	 */
+	bool snapshot(SharedCounts& out, int maxRetries = 1000) const;
+
+      private:
+	std::string _name;
+	const SharedCountsSegment* _segment = nullptr;
+};
+} // namespace peopleDetector
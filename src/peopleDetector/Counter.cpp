@@ -1,23 +1,68 @@
 #include "Counter.hpp"
 namespace peopleDetector
 {
-std::atomic<int> Counter::status{0};
-std::atomic<int> Counter::entered{0};
-std::atomic<int> Counter::left{0};
+Counter::Counter(const int startValue)
+{
+	status = startValue;
+	for (int i = 0; i < maxClasses; ++i)
+		classIds[i] = -1;
+}
+
+int Counter::findTally(const int classId) const
+{
+	for (int i = 0; i < maxClasses; ++i) {
+		if (classIds[i].load(std::memory_order_acquire) == classId)
+			return i;
+	}
+	return -1;
+}
 
-Counter::Counter(const int startValue = 0) { status = startValue; }
+int Counter::claimTally(const int classId)
+{
+	if (classId < 0)
+		return -1;
+	for (int i = 0; i < maxClasses; ++i) {
+		int id = classIds[i].load(std::memory_order_acquire);
+		if (id < 0 && classIds[i].compare_exchange_strong(id, classId, std::memory_order_acq_rel))
+			return i;
+		if (id == classId)
+			return i;
+	}
+	return -1; // More classes than tallies, only the totals count
+}
 
-void Counter::decrement()
+void Counter::decrement(const int gate, const int classId)
 {
 	--status;
 	++left;
+	if (gate >= 0 && gate < maxGates)
+		++gateLeft[gate];
+	const int tally = claimTally(classId);
+	if (tally >= 0)
+		++classLeft[tally];
 }
 
-void Counter::increment()
+void Counter::increment(const int gate, const int classId)
 {
 	++status;
 	++entered;
-	;
+	if (gate >= 0 && gate < maxGates)
+		++gateEntered[gate];
+	const int tally = claimTally(classId);
+	if (tally >= 0)
+		++classEntered[tally];
+}
+
+void Counter::enterGate(const int gate)
+{
+	if (gate >= 0 && gate < maxGates)
+		++gateEntered[gate];
+}
+
+void Counter::leaveGate(const int gate)
+{
+	if (gate >= 0 && gate < maxGates)
+		++gateLeft[gate];
 }
 
 void Counter::reset()
@@ -25,6 +70,32 @@ void Counter::reset()
 	status = 0;
 	entered = 0;
 	left = 0;
+	for (int i = 0; i < maxGates; ++i) {
+		gateEntered[i] = 0;
+		gateLeft[i] = 0;
+	}
+	for (int i = 0; i < maxClasses; ++i) {
+		classIds[i] = -1;
+		classEntered[i] = 0;
+		classLeft[i] = 0;
+	}
+}
+
+void Counter::restore(const int statusValue, const int enteredValue, const int leftValue, const int* gateEnteredValues,
+		      const int* gateLeftValues, const int* classIdValues, const int* classEnteredValues, const int* classLeftValues)
+{
+	status = statusValue;
+	entered = enteredValue;
+	left = leftValue;
+	for (int i = 0; i < maxGates; ++i) {
+		gateEntered[i] = gateEnteredValues[i];
+		gateLeft[i] = gateLeftValues[i];
+	}
+	for (int i = 0; i < maxClasses; ++i) {
+		classIds[i] = classIdValues[i];
+		classEntered[i] = classEnteredValues[i];
+		classLeft[i] = classLeftValues[i];
+	}
 }
 
 void Counter::set(const int value) { status = value; }
@@ -32,5 +103,18 @@ void Counter::set(const int value) { status = value; }
 int Counter::getStatus() const { return status; }
 int Counter::getEntered() const { return entered; }
 int Counter::getLeft() const { return left; }
+int Counter::getEntered(const int gate) const { return gate >= 0 && gate < maxGates ? gateEntered[gate].load() : 0; }
+int Counter::getLeft(const int gate) const { return gate >= 0 && gate < maxGates ? gateLeft[gate].load() : 0; }
+int Counter::getClassId(const int tally) const { return tally >= 0 && tally < maxClasses ? classIds[tally].load() : -1; }
+int Counter::getEnteredByClass(const int classId) const
+{
+	const int tally = classId >= 0 ? findTally(classId) : -1;
+	return tally >= 0 ? classEntered[tally].load() : 0;
+}
+int Counter::getLeftByClass(const int classId) const
+{
+	const int tally = classId >= 0 ? findTally(classId) : -1;
+	return tally >= 0 ? classLeft[tally].load() : 0;
+}
 
 } // namespace peopleDetector
\ No newline at end of file
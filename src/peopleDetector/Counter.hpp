@@ -5,18 +5,42 @@ namespace peopleDetector
 class Counter
 {
       public:
-	Counter(const int startValue);
-	void increment();
-	void decrement();
+	static const int maxGates = 8;
+	static const int maxClasses = 8; // Classes with their own tally, taken in the order they are first counted
+
+	Counter(const int startValue = 0);
+	void increment(const int gate = 0, const int classId = -1); // classId < 0 only counts the totals
+	void decrement(const int gate = 0, const int classId = -1);
+	void enterGate(const int gate); // Crossing of a further gate, its own tally only; the totals follow gate 0
+	void leaveGate(const int gate);
 	void set(const int value);
 	void reset();
+	void restore(const int status, const int entered, const int left, const int* gateEntered, const int* gateLeft, const int* classIds,
+		     const int* classEntered, const int* classLeft);
 	int getStatus() const;
 	int getEntered() const;
 	int getLeft() const;
+	int getEntered(const int gate) const;
+	int getLeft(const int gate) const;
+	int getClassId(const int tally) const; // Class of tally 0..maxClasses-1, -1 if unused
+	int getEnteredByClass(const int classId) const;
+	int getLeftByClass(const int classId) const;
 
       private:
-	static std::atomic<int> status;
-	static std::atomic<int> entered;
-	static std::atomic<int> left;
+	// Per instance, so independent trackers (e.g. batch replays) keep
+	// separate counts
+	std::atomic<int> status{0};
+	std::atomic<int> entered{0};
+	std::atomic<int> left{0};
+	std::atomic<int> gateEntered[maxGates] = {};
+	std::atomic<int> gateLeft[maxGates] = {};
+	// Keyed by detector class id, so a changed class selection or a
+	// restored checkpoint never credits another class
+	std::atomic<int> classIds[maxClasses];
+	std::atomic<int> classEntered[maxClasses] = {};
+	std::atomic<int> classLeft[maxClasses] = {};
+
+	int findTally(const int classId) const;
+	int claimTally(const int classId);
 };
 } // namespace peopleDetector
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstdlib>
+#include <logging.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "CpuPeopleDetector.hpp"
+namespace peopleDetector
+{
+
+// out[i] = max(a[i], b[i], c[i]) (dilate) or min(a[i], b[i], c[i]) (erode)
+template <bool Dilate> static void combine3(const uint8_t* a, const uint8_t* b, const uint8_t* c, uint8_t* out, size_t n)
+{
+	size_t i = 0;
+#if defined(__aarch64__)
+	for (; i + 16 <= n; i += 16) {
+		const uint8x16_t va = vld1q_u8(a + i);
+		const uint8x16_t vb = vld1q_u8(b + i);
+		const uint8x16_t vc = vld1q_u8(c + i);
+		vst1q_u8(out + i, Dilate ? vmaxq_u8(vmaxq_u8(va, vb), vc) : vminq_u8(vminq_u8(va, vb), vc));
+	}
+#elif defined(__SSE2__)
+	for (; i + 16 <= n; i += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+		const __m128i vc = _mm_loadu_si128((const __m128i*)(c + i));
+		_mm_storeu_si128((__m128i*)(out + i), Dilate ? _mm_max_epu8(_mm_max_epu8(va, vb), vc) : _mm_min_epu8(_mm_min_epu8(va, vb), vc));
+	}
+#endif
+	for (; i < n; ++i)
+		out[i] = Dilate ? std::max(std::max(a[i], b[i]), c[i]) : std::min(std::min(a[i], b[i]), c[i]);
+}
+
+// Separable 3x3 erosion / dilation of src into dst, edges are replicated.
+// src and dst may be the same buffer.
+template <bool Dilate> static void filter3x3(const uint8_t* src, uint8_t* dst, uint8_t* tmp, uint32_t cols, uint32_t rows)
+{
+	for (uint32_t y = 0; y < rows; ++y) {
+		const uint8_t* s = src + y * cols;
+		uint8_t* h = tmp + y * cols;
+		h[0] = Dilate ? std::max(s[0], s[1]) : std::min(s[0], s[1]);
+		combine3<Dilate>(s, s + 1, s + 2, h + 1, cols - 2);
+		h[cols - 1] = Dilate ? std::max(s[cols - 2], s[cols - 1]) : std::min(s[cols - 2], s[cols - 1]);
+	}
+	for (uint32_t y = 0; y < rows; ++y) {
+		const uint8_t* above = tmp + (y > 0 ? y - 1 : 0) * cols;
+		const uint8_t* below = tmp + (y + 1 < rows ? y + 1 : y) * cols;
+		combine3<Dilate>(above, tmp + y * cols, below, dst + y * cols, cols);
+	}
+}
+
+static uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t x)
+{
+	while (parent[x] != x) {
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+CpuPeopleDetector::CpuPeopleDetector() : _detectionSets(numDetectionSets_ * _maxDetections)
+{
+	_detectionRing.init(_detectionSets.data(), numDetectionSets_, _maxDetections);
+}
+
+void CpuPeopleDetector::updateClassMask(const Config& config)
+{
+	if (_classMaskCompiled && _classMaskSelection == config.countedClasses)
+		return;
+	_classMaskCompiled = true;
+	_classMaskSelection = config.countedClasses;
+
+	// Blobs are people; other COCO labels or ids are unknown here
+	static const std::vector<std::string> labels = {"void", "person"};
+	_classMask.compile(config.countedClasses, labels);
+	if (_classMask.slot(personClassId) < 0)
+		LogError("CpuPeopleDetector -- '%s' does not select person, nothing will be counted\n", config.countedClasses.c_str());
+}
+
+void CpuPeopleDetector::resize(uint32_t width, uint32_t height)
+{
+	_width = width;
+	_height = height;
+	_cols = (width + _sampleStep - 1) / _sampleStep;
+	_rows = (height + _sampleStep - 1) / _sampleStep;
+
+	const size_t n = _cols * _rows;
+	_current.assign(n, 0);
+	_background.assign(n, 0);
+	_mask.assign(n, 0);
+	_scratch.assign(n, 0);
+	_labels.assign(n, 0);
+	_hasBackground = false;
+}
+
+void CpuPeopleDetector::sample(const uint8_t* rgb, uint32_t width)
+{
+	const size_t rowStride = (size_t)width * 3 * _sampleStep;
+	const size_t colStride = 3 * _sampleStep;
+	uint8_t* out = _current.data();
+
+	for (uint32_t r = 0; r < _rows; ++r) {
+		const uint8_t* px = rgb + r * rowStride;
+		for (uint32_t c = 0; c < _cols; ++c, px += colStride)
+			*out++ = (px[0] + 2 * px[1] + px[2]) >> 2;
+	}
+}
+
+void CpuPeopleDetector::segment()
+{
+	// Background samples follow the scene quickly (rounding average),
+	// foreground samples creep towards the frame by one luma step per frame
+	// (approximate median) so people standing still are only absorbed
+	// slowly and ghosts of people who left fade out.
+	const size_t n = _current.size();
+	const uint8_t* cur = _current.data();
+	uint8_t* bg = _background.data();
+	uint8_t* mask = _mask.data();
+	size_t i = 0;
+
+#if defined(__aarch64__)
+	const uint8x16_t thr = vdupq_n_u8(_foregroundThreshold);
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; i + 16 <= n; i += 16) {
+		const uint8x16_t c = vld1q_u8(cur + i);
+		const uint8x16_t b = vld1q_u8(bg + i);
+		const uint8x16_t fg = vcgtq_u8(vabdq_u8(c, b), thr);
+		const uint8x16_t avg = vrhaddq_u8(b, c);
+		const uint8x16_t creep = vsubq_u8(vaddq_u8(b, vminq_u8(vqsubq_u8(c, b), one)), vminq_u8(vqsubq_u8(b, c), one));
+		vst1q_u8(mask + i, fg);
+		vst1q_u8(bg + i, vbslq_u8(fg, creep, avg));
+	}
+#elif defined(__SSE2__)
+	const __m128i thr = _mm_set1_epi8((char)_foregroundThreshold);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi8((char)0xFF);
+	const __m128i one = _mm_set1_epi8(1);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)(cur + i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+		const __m128i up = _mm_subs_epu8(c, b);
+		const __m128i down = _mm_subs_epu8(b, c);
+		const __m128i fg = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(_mm_or_si128(up, down), thr), zero), ones);
+		const __m128i avg = _mm_avg_epu8(b, c);
+		const __m128i creep = _mm_sub_epi8(_mm_add_epi8(b, _mm_min_epu8(up, one)), _mm_min_epu8(down, one));
+		_mm_storeu_si128((__m128i*)(mask + i), fg);
+		_mm_storeu_si128((__m128i*)(bg + i), _mm_or_si128(_mm_and_si128(fg, creep), _mm_andnot_si128(fg, avg)));
+	}
+#endif
+	for (; i < n; ++i) {
+		const bool fg = std::abs(cur[i] - bg[i]) > _foregroundThreshold;
+		mask[i] = fg ? 0xFF : 0x00;
+		if (!fg)
+			bg[i] = (cur[i] + bg[i] + 1) >> 1;
+		else
+			bg[i] += cur[i] > bg[i] ? 1 : -1;
+	}
+}
+
+void CpuPeopleDetector::morphology()
+{
+	// Opening removes speckle noise, the extra dilation joins limbs and
+	// torso into one blob.
+	filter3x3<false>(_mask.data(), _mask.data(), _scratch.data(), _cols, _rows);
+	filter3x3<true>(_mask.data(), _mask.data(), _scratch.data(), _cols, _rows);
+	filter3x3<true>(_mask.data(), _mask.data(), _scratch.data(), _cols, _rows);
+}
+
+int CpuPeopleDetector::label()
+{
+	// First pass: provisional 4-connected labels, equivalences in _parent
+	_parent.clear();
+	_parent.push_back(0);
+	for (uint32_t y = 0; y < _rows; ++y) {
+		for (uint32_t x = 0; x < _cols; ++x) {
+			const size_t i = y * _cols + x;
+			if (!_mask[i]) {
+				_labels[i] = 0;
+				continue;
+			}
+			const uint32_t left = x > 0 ? _labels[i - 1] : 0;
+			const uint32_t up = y > 0 ? _labels[i - _cols] : 0;
+
+			if (!left && !up) {
+				_labels[i] = _parent.size();
+				_parent.push_back(_parent.size());
+			} else if (left && up) {
+				const uint32_t a = findRoot(_parent, left);
+				const uint32_t b = findRoot(_parent, up);
+				_parent[std::max(a, b)] = std::min(a, b);
+				_labels[i] = std::min(a, b);
+			} else {
+				_labels[i] = left ? left : up;
+			}
+		}
+	}
+
+	// Second pass: accumulate bounding boxes per root label
+	_blobIndex.assign(_parent.size(), -1);
+	_blobs.clear();
+	for (uint32_t y = 0; y < _rows; ++y) {
+		for (uint32_t x = 0; x < _cols; ++x) {
+			const uint32_t l = _labels[y * _cols + x];
+			if (!l)
+				continue;
+			const uint32_t root = findRoot(_parent, l);
+			if (_blobIndex[root] < 0) {
+				_blobIndex[root] = _blobs.size();
+				_blobs.push_back({(int)x, (int)y, (int)x, (int)y, 0});
+			}
+			Blob& blob = _blobs[_blobIndex[root]];
+			blob.minX = std::min(blob.minX, (int)x);
+			blob.maxX = std::max(blob.maxX, (int)x);
+			blob.minY = std::min(blob.minY, (int)y);
+			blob.maxY = std::max(blob.maxY, (int)y);
+			++blob.area;
+		}
+	}
+	return _blobs.size();
+}
+
+int CpuPeopleDetector::Detect(const void* input, uint32_t width, uint32_t height, DetectionLease& lease)
+{
+	if (!input || width < 3u * _sampleStep || height < 3u * _sampleStep)
+		return -1;
+
+	lease = _detectionRing.lease();
+	if (!lease)
+		return -1;
+	Detection* det = lease.get();
+
+	if (width != _width || height != _height)
+		resize(width, height);
+
+	sample((const uint8_t*)input, width);
+
+	if (!_hasBackground) {
+		_background = _current;
+		_hasBackground = true;
+		return 0;
+	}
+
+	segment();
+	morphology();
+	label();
+
+	updateClassMask(currentConfig());
+	const int classSlot = _classMask.slot(personClassId);
+	if (classSlot < 0)
+		return 0;
+
+	const int maxArea = _maxBlobFraction * _cols * _rows;
+	int numDetections = 0;
+
+	for (const Blob& blob : _blobs) {
+		const int w = blob.maxX - blob.minX + 1;
+		const int h = blob.maxY - blob.minY + 1;
+		const float aspect = (float)h / w;
+
+		if (blob.area < _minBlobArea || blob.area > maxArea)
+			continue;
+		if (aspect < _minAspect || aspect > _maxAspect)
+			continue;
+		if (numDetections >= (int)_maxDetections)
+			break;
+
+		Detection& d = det[numDetections];
+		d = Detection();
+		d.ClassID = personClassId;
+		d.classSlot = classSlot;
+		d.Confidence = (float)blob.area / (w * h);
+		d.Left = blob.minX * _sampleStep;
+		d.Top = blob.minY * _sampleStep;
+		d.Right = std::min((blob.maxX + 1) * _sampleStep, (int)width - 1);
+		d.Bottom = std::min((blob.maxY + 1) * _sampleStep, (int)height - 1);
+		++numDetections;
+	}
+
+	// order by area (descending) like PeopleDetector::sortDetections
+	std::sort(det, det + numDetections, [](const Detection& a, const Detection& b) { return a.Area() > b.Area(); });
+	for (int i = 0; i < numDetections; i++)
+		det[i].Instance = i;
+
+	return numDetections;
+}
+} // namespace peopleDetector
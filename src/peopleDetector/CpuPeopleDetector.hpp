@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ClassMask.hpp"
+#include "Config.hpp"
+#include "Detection.hpp"
+#include "DetectionRing.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * CPU detection backend for hosts without a GPU. People are found as
+ * foreground blobs: the frame is sampled into a small luma image, compared
+ * against a running background model, cleaned up with 3x3 morphology and
+ * split into connected components. The output contract matches
+ * PeopleDetector::Detect(): a lease on a set of a DetectionRing plus the
+ * number of valid entries, sorted by area. Blobs are reported as class
+ * personClassId, and only if Config::countedClasses selects it.
+ */
+class CpuPeopleDetector
+{
+      public:
+	// ################### Settings ###################
+	const int _sampleStep = 4;		 // Sample every n-th pixel in x and y
+	const uint8_t _foregroundThreshold = 30; // Luma difference for a sample to be foreground
+	const int _minBlobArea = 60;		 // Minimum blob size in samples
+	const float _maxBlobFraction = 0.5f;	 // Larger blobs are lighting changes, not people
+	const float _minAspect = 0.5f;		 // Height / width bounds of a person blob (overhead
+	const float _maxAspect = 5.0f;		 // views are roughly square, side views tall)
+	const uint32_t _maxDetections = 100;
+	// ################################################
+
+	static const uint32_t personClassId = 1; // person in the COCO label set used by PeopleDetector
+
+	CpuPeopleDetector();
+
+	/**
+	 * Detect people in an RGB8 frame. On success lease holds the detection
+	 * set of this frame, which stays unchanged until every reference to it
+	 * is dropped. Returns -1 if every set is still held.
+	 */
+	int Detect(const void* input, uint32_t width, uint32_t height, DetectionLease& lease);
+
+	template <typename T> int Detect(T* image, uint32_t width, uint32_t height, DetectionLease& lease)
+	{
+		return Detect((const void*)image, width, height, lease);
+	}
+
+	inline uint32_t GetMaxDetections() const { return _maxDetections; }
+	inline const DetectionRing& GetDetectionRing() const { return _detectionRing; }
+
+      private:
+	struct Blob {
+		int minX, minY, maxX, maxY;
+		int area;
+	};
+
+	void updateClassMask(const Config& config); // Recompile _classMask if the class selection changed
+	void resize(uint32_t width, uint32_t height);
+	void sample(const uint8_t* rgb, uint32_t width);
+	void segment();
+	void morphology();
+	int label();
+
+	uint32_t _cols = 0;
+	uint32_t _rows = 0;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	bool _hasBackground = false;
+
+	ClassMask _classMask;		 // Against the labels the detector can report
+	std::string _classMaskSelection; // Selection _classMask was compiled from
+	bool _classMaskCompiled = false;
+
+	std::vector<uint8_t> _current;	  // Downsampled luma of the current frame
+	std::vector<uint8_t> _background; // Running background model
+	std::vector<uint8_t> _mask;	  // Foreground mask (0x00 / 0xFF)
+	std::vector<uint8_t> _scratch;	  // Morphology intermediate
+	std::vector<uint32_t> _labels;	  // Connected component labels
+	std::vector<uint32_t> _parent;	  // Union-find forest over provisional labels
+	std::vector<int> _blobIndex;	  // Blob of each root label, -1 if none yet
+	std::vector<Blob> _blobs;
+
+	std::vector<Detection> _detectionSets; // ringbuffer of numDetectionSets_ * _maxDetections
+	DetectionRing _detectionRing;	       // leases of the sets in _detectionSets
+	static const uint32_t numDetectionSets_ = 16;
+};
+} // namespace peopleDetector
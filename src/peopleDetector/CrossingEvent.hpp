@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EventRing.hpp"
+
+namespace peopleDetector
+{
+
+enum class CrossingDirection : int { IN = 1, OUT = 2 };
+
+// One counting-line crossing, emitted by TrackedObject::updateCounter()
+struct CrossingEvent {
+	int64_t timestampNs; // Wall clock, nanoseconds since the epoch
+	int trackId;
+	int gate;
+	uint32_t classId; // Detector class of the track
+	CrossingDirection direction;
+	float confidence; // Detector confidence of the detection that crossed
+};
+
+using CrossingEventRing = EventRing<CrossingEvent, 4096>;
+} // namespace peopleDetector
@@ -1,16 +1,20 @@
 #pragma once
 #include <array>
+#include <cmath>
 #include <cstdint>
-#include <jetson-inference/tensorNet.h>
 
 namespace peopleDetector
 {
 
+/**< Number of bins of the quantised colour histogram (4 levels per channel) */
+static const int kAppearanceBins = 64;
+
+/**< Colour histogram normalised to sum to ~255 */
+using Appearance = std::array<uint8_t, kAppearanceBins>;
+
 struct Detection {
-	// Object Info
-	uint32_t Instance; /**< Index of this unique object instance */
-	uint32_t ClassID;  /**< Class index of the detected object. */
-	float Confidence;  /**< Confidence value of the detected object. */
+	// Geometry first, as association and clustering read it for every
+	// pair; batched code uses DetectionBatch instead
 
 	// Bounding Box Coordinates
 	float Left;   /**< Left bounding box coordinate (in pixels) */
@@ -20,9 +24,20 @@ struct Detection {
 
 	// tracking attribute
 	float x_mid, y_mid;
-	int frameId;
 	bool associated = false;
-	volatile int trackId = -1;
+
+	// Object info and bookkeeping
+	uint32_t Instance; /**< Index of this unique object instance */
+	uint32_t ClassID;  /**< Class index of the detected object. */
+	int classSlot = 0; /**< Index of ClassID in the counted classes, see ClassMask; tallies are keyed by ClassID */
+	float Confidence;  /**< Confidence value of the detected object. */
+	int frameId;
+	int trackId = -1; /**< Written by the tracker thread on association */
+
+	// appearance signature, filled in by computeAppearance()
+	Appearance appearance;
+	bool hasAppearance = false;
+
 	/**< Calculate the width of the objectis */
 	inline float Width() const { return Right - Left; }
 
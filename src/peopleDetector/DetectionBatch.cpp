@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "DetectionBatch.hpp"
+namespace peopleDetector
+{
+
+// Four-wide float helpers over NEON / SSE, the scalar tails below each loop
+// handle the remainder and targets without either.
+#if defined(__aarch64__)
+#define BATCH_SIMD 1
+typedef float32x4_t f4;
+static inline f4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, f4 v) { vst1q_f32(p, v); }
+static inline f4 set4(float x) { return vdupq_n_f32(x); }
+static inline f4 add4(f4 a, f4 b) { return vaddq_f32(a, b); }
+static inline f4 sub4(f4 a, f4 b) { return vsubq_f32(a, b); }
+static inline f4 mul4(f4 a, f4 b) { return vmulq_f32(a, b); }
+static inline f4 div4(f4 a, f4 b) { return vdivq_f32(a, b); }
+static inline f4 min4(f4 a, f4 b) { return vminq_f32(a, b); }
+static inline f4 max4(f4 a, f4 b) { return vmaxq_f32(a, b); }
+static inline f4 sqrt4(f4 a) { return vsqrtq_f32(a); }
+#elif defined(__SSE2__)
+#define BATCH_SIMD 1
+typedef __m128 f4;
+static inline f4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, f4 v) { _mm_storeu_ps(p, v); }
+static inline f4 set4(float x) { return _mm_set1_ps(x); }
+static inline f4 add4(f4 a, f4 b) { return _mm_add_ps(a, b); }
+static inline f4 sub4(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+static inline f4 mul4(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+static inline f4 div4(f4 a, f4 b) { return _mm_div_ps(a, b); }
+static inline f4 min4(f4 a, f4 b) { return _mm_min_ps(a, b); }
+static inline f4 max4(f4 a, f4 b) { return _mm_max_ps(a, b); }
+static inline f4 sqrt4(f4 a) { return _mm_sqrt_ps(a); }
+#endif
+
+void DetectionBatch::clear()
+{
+	_left.clear();
+	_top.clear();
+	_right.clear();
+	_bottom.clear();
+	_xMid.clear();
+	_yMid.clear();
+}
+
+void DetectionBatch::reserve(size_t n)
+{
+	_left.reserve(n);
+	_top.reserve(n);
+	_right.reserve(n);
+	_bottom.reserve(n);
+	_xMid.reserve(n);
+	_yMid.reserve(n);
+}
+
+void DetectionBatch::resize(size_t n)
+{
+	if (n >= size())
+		return;
+	_left.resize(n);
+	_top.resize(n);
+	_right.resize(n);
+	_bottom.resize(n);
+	_xMid.resize(n);
+	_yMid.resize(n);
+}
+
+int DetectionBatch::push(const Detection& det)
+{
+	_left.push_back(det.Left);
+	_top.push_back(det.Top);
+	_right.push_back(det.Right);
+	_bottom.push_back(det.Bottom);
+	_xMid.push_back((det.Left + det.Right) / 2);
+	_yMid.push_back((det.Top + det.Bottom) / 2);
+	return size() - 1;
+}
+
+void DetectionBatch::setBox(int i, float left, float top, float right, float bottom)
+{
+	_left[i] = left;
+	_top[i] = top;
+	_right[i] = right;
+	_bottom[i] = bottom;
+	_xMid[i] = (left + right) / 2;
+	_yMid[i] = (top + bottom) / 2;
+}
+
+void DetectionBatch::centreDistances(float x, float y, float* out) const
+{
+	const size_t n = size();
+	size_t i = 0;
+#ifdef BATCH_SIMD
+	const f4 vx = set4(x);
+	const f4 vy = set4(y);
+	for (; i + 4 <= n; i += 4) {
+		const f4 dx = sub4(load4(&_xMid[i]), vx);
+		const f4 dy = sub4(load4(&_yMid[i]), vy);
+		store4(out + i, sqrt4(add4(mul4(dx, dx), mul4(dy, dy))));
+	}
+#endif
+	for (; i < n; ++i) {
+		const float dx = _xMid[i] - x;
+		const float dy = _yMid[i] - y;
+		out[i] = std::sqrt(dx * dx + dy * dy);
+	}
+}
+
+void DetectionBatch::mahalanobis(float x, float y, float i00, float i01, float i11, float* out) const
+{
+	const size_t n = size();
+	size_t i = 0;
+#ifdef BATCH_SIMD
+	const f4 vx = set4(x);
+	const f4 vy = set4(y);
+	const f4 a = set4(i00);
+	const f4 b = set4(2 * i01);
+	const f4 c = set4(i11);
+	for (; i + 4 <= n; i += 4) {
+		const f4 dx = sub4(load4(&_xMid[i]), vx);
+		const f4 dy = sub4(load4(&_yMid[i]), vy);
+		store4(out + i, add4(add4(mul4(a, mul4(dx, dx)), mul4(b, mul4(dx, dy))), mul4(c, mul4(dy, dy))));
+	}
+#endif
+	for (; i < n; ++i) {
+		const float dx = _xMid[i] - x;
+		const float dy = _yMid[i] - y;
+		out[i] = i00 * dx * dx + 2 * i01 * dx * dy + i11 * dy * dy;
+	}
+}
+
+// Intersection area of box (l, t, r, b) with boxes [i, i + 4) of the arrays
+#ifdef BATCH_SIMD
+static inline f4 intersect4(const float* L, const float* T, const float* R, const float* B, f4 l, f4 t, f4 r, f4 b)
+{
+	const f4 zero = set4(0.0f);
+	const f4 w = max4(zero, sub4(min4(load4(R), r), max4(load4(L), l)));
+	const f4 h = max4(zero, sub4(min4(load4(B), b), max4(load4(T), t)));
+	return mul4(w, h);
+}
+#endif
+
+static inline float intersect1(float L, float T, float R, float B, float l, float t, float r, float b)
+{
+	const float w = std::max(0.0f, std::min(R, r) - std::max(L, l));
+	const float h = std::max(0.0f, std::min(B, b) - std::max(T, t));
+	return w * h;
+}
+
+void DetectionBatch::overlapRatios(float l, float t, float r, float b, size_t n, float* out) const
+{
+	n = std::min(n, size());
+	const float area = (r - l) * (b - t);
+	size_t i = 0;
+#ifdef BATCH_SIMD
+	const f4 vl = set4(l), vt = set4(t), vr = set4(r), vb = set4(b), va = set4(area);
+	for (; i + 4 <= n; i += 4) {
+		const f4 inter = intersect4(&_left[i], &_top[i], &_right[i], &_bottom[i], vl, vt, vr, vb);
+		const f4 areas = mul4(sub4(load4(&_right[i]), load4(&_left[i])), sub4(load4(&_bottom[i]), load4(&_top[i])));
+		store4(out + i, div4(inter, max4(areas, va)));
+	}
+#endif
+	for (; i < n; ++i) {
+		const float inter = intersect1(_left[i], _top[i], _right[i], _bottom[i], l, t, r, b);
+		const float other = (_right[i] - _left[i]) * (_bottom[i] - _top[i]);
+		out[i] = inter / std::max(other, area);
+	}
+}
+} // namespace peopleDetector
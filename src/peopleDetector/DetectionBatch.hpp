@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Structure-of-arrays view of one frame's detections. Box coordinates and
+ * centres, which association and clustering scan for every pair, live in
+ * contiguous float arrays so the batched geometry helpers can process four
+ * boxes per instruction. Indices match the order the detections were pushed.
+ */
+class DetectionBatch
+{
+      public:
+	void clear();
+	void reserve(size_t n);
+	void resize(size_t n); // Shrink only, drops trailing entries
+	int push(const Detection& det);
+	inline size_t size() const { return _left.size(); }
+
+	void setBox(int i, float left, float top, float right, float bottom);
+
+	inline float left(int i) const { return _left[i]; }
+	inline float top(int i) const { return _top[i]; }
+	inline float right(int i) const { return _right[i]; }
+	inline float bottom(int i) const { return _bottom[i]; }
+	inline float xMid(int i) const { return _xMid[i]; }
+	inline float yMid(int i) const { return _yMid[i]; }
+
+	/**< out[i] = Euclidean distance from (x, y) to the centre of box i */
+	void centreDistances(float x, float y, float* out) const;
+
+	/**< out[i] = squared Mahalanobis distance of centre i to (x, y) given the
+	 * inverse covariance [i00 i01; i01 i11] */
+	void mahalanobis(float x, float y, float i00, float i01, float i11, float* out) const;
+
+	/**< out[i] = intersection area / larger area of box i and the given box,
+	 * the ratio Detection::Intersects() thresholds, for the first n boxes */
+	void overlapRatios(float l, float t, float r, float b, size_t n, float* out) const;
+
+      private:
+	std::vector<float> _left, _top, _right, _bottom;
+	std::vector<float> _xMid, _yMid;
+};
+} // namespace peopleDetector
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <logging.h>
+
+#include "DetectionLog.hpp"
+namespace peopleDetector
+{
+
+static int64_t wallTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+DetectionLogWriter::~DetectionLogWriter() { close(); }
+
+bool DetectionLogWriter::open(const std::string& path, uint32_t width, uint32_t height, uint64_t maxBytes)
+{
+	close();
+	_file = fopen(path.c_str(), "wb");
+	if (!_file) {
+		LogError("DetectionLog -- failed to open %s\n", path.c_str());
+		return false;
+	}
+	const DetectionLogHeader header = {kDetectionLogMagic, kDetectionLogVersion, width, height, wallTimeNs()};
+	fwrite(&header, sizeof(header), 1, _file);
+	_bytes = sizeof(header);
+	_maxBytes = maxBytes;
+	return true;
+}
+
+void DetectionLogWriter::close()
+{
+	if (_file)
+		fclose(_file);
+	_file = nullptr;
+}
+
+void DetectionLogWriter::write(uint32_t frameId, const std::vector<std::shared_ptr<Detection>>& detections)
+{
+	if (!_file)
+		return;
+	const uint64_t frameBytes = sizeof(DetectionLogFrame) + detections.size() * sizeof(DetectionLogRecord);
+	if (_bytes + frameBytes > _maxBytes) {
+		LogInfo("DetectionLog -- size limit of %llu bytes reached, recording stopped\n", (unsigned long long)_maxBytes);
+		close();
+		return;
+	}
+	_bytes += frameBytes;
+
+	const DetectionLogFrame frame = {wallTimeNs(), frameId, (uint32_t)detections.size()};
+	fwrite(&frame, sizeof(frame), 1, _file);
+	for (const auto& det : detections) {
+		DetectionLogRecord record = {};
+		record.left = det->Left;
+		record.top = det->Top;
+		record.right = det->Right;
+		record.bottom = det->Bottom;
+		record.confidence = det->Confidence;
+		record.classId = det->ClassID;
+		record.classSlot = det->classSlot;
+		record.hasAppearance = det->hasAppearance;
+		record.appearance = det->appearance;
+		fwrite(&record, sizeof(record), 1, _file);
+	}
+}
+
+DetectionLogReader::~DetectionLogReader() { close(); }
+
+bool DetectionLogReader::open(const std::string& path)
+{
+	close();
+	_file = fopen(path.c_str(), "rb");
+	if (!_file) {
+		LogError("DetectionLog -- failed to open %s\n", path.c_str());
+		return false;
+	}
+	_buffer.resize(_bufferSize);
+	setvbuf(_file, _buffer.data(), _IOFBF, _buffer.size());
+
+	if (fread(&_header, sizeof(_header), 1, _file) != 1 || _header.magic != kDetectionLogMagic ||
+	    _header.version != kDetectionLogVersion) {
+		LogError("DetectionLog -- %s is not a detection log (version %u)\n", path.c_str(), kDetectionLogVersion);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void DetectionLogReader::close()
+{
+	if (_file)
+		fclose(_file);
+	_file = nullptr;
+}
+
+bool DetectionLogReader::readFrame(DetectionLogFrame& frame, std::vector<Detection>& detections)
+{
+	if (!_file || fread(&frame, sizeof(frame), 1, _file) != 1)
+		return false;
+
+	_records.resize(frame.numDetections);
+	if (fread(_records.data(), sizeof(DetectionLogRecord), frame.numDetections, _file) != frame.numDetections) {
+		LogError("DetectionLog -- truncated frame %u\n", frame.frameId);
+		return false;
+	}
+
+	detections.resize(frame.numDetections);
+	for (uint32_t i = 0; i < frame.numDetections; ++i) {
+		const DetectionLogRecord& record = _records[i];
+		Detection& det = detections[i];
+		det = Detection();
+		det.Instance = i;
+		det.Left = record.left;
+		det.Top = record.top;
+		det.Right = record.right;
+		det.Bottom = record.bottom;
+		det.Confidence = record.confidence;
+		det.ClassID = record.classId;
+		det.classSlot = record.classSlot;
+		det.hasAppearance = record.hasAppearance;
+		det.appearance = record.appearance;
+	}
+	return true;
+}
+} // namespace peopleDetector
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+static const uint32_t kDetectionLogMagic = 0x4c444350; // "PCDL"
+static const uint32_t kDetectionLogVersion = 1;
+
+struct DetectionLogHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width; // Frame size the boxes refer to
+	uint32_t height;
+	int64_t startWallTimeNs; // system_clock time of the first frame
+};
+
+// Per frame, followed by numDetections DetectionLogRecords
+struct DetectionLogFrame {
+	int64_t timestampNs; // system_clock time of the frame
+	uint32_t frameId;
+	uint32_t numDetections;
+};
+
+// Detector output of one box, everything the tracker reads
+struct DetectionLogRecord {
+	float left, top, right, bottom;
+	float confidence;
+	uint32_t classId;
+	int32_t classSlot;
+	uint8_t hasAppearance;
+	uint8_t reserved[3];
+	Appearance appearance;
+};
+
+/**
+ * Appends the per-frame detector output of one camera to a binary log, so
+ * counts can be recomputed offline (PeopleCounterBatch) without the video.
+ * Writes go through the stdio buffer; nothing is allocated per frame. A log
+ * stops growing at maxBytes: the frame that would pass it closes the file.
+ */
+class DetectionLogWriter
+{
+      public:
+	~DetectionLogWriter();
+
+	bool open(const std::string& path, uint32_t width, uint32_t height, uint64_t maxBytes = UINT64_MAX);
+	void close();
+	void write(uint32_t frameId, const std::vector<std::shared_ptr<Detection>>& detections);
+
+	inline uint64_t getBytes() const { return _bytes; }
+
+      private:
+	FILE* _file = nullptr;
+	uint64_t _bytes = 0;
+	uint64_t _maxBytes = UINT64_MAX;
+};
+
+/**
+ * Sequential reader of a detection log. readFrame() refills the caller's
+ * detections in place, so replaying a log reuses the same objects.
+ */
+class DetectionLogReader
+{
+      public:
+	// ################### Settings ###################
+	const size_t _bufferSize = 1 << 20; // stdio buffer, logs are read front to back
+	// ################################################
+
+	~DetectionLogReader();
+
+	bool open(const std::string& path);
+	void close();
+
+	/**< Next frame into detections (resized to its count), false at the end of the log */
+	bool readFrame(DetectionLogFrame& frame, std::vector<Detection>& detections);
+
+	inline const DetectionLogHeader& getHeader() const { return _header; }
+
+      private:
+	FILE* _file = nullptr;
+	DetectionLogHeader _header = {};
+	std::vector<DetectionLogRecord> _records;
+	std::vector<char> _buffer;
+};
+} // namespace peopleDetector
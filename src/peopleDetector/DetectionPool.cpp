@@ -0,0 +1,32 @@
+#include <atomic>
+
+#include "DetectionPool.hpp"
+namespace peopleDetector
+{
+
+DetectionPool::DetectionPool(size_t initialSize)
+{
+	_pool.reserve(initialSize);
+	for (size_t i = 0; i < initialSize; ++i)
+		_pool.push_back(std::make_shared<Detection>());
+}
+
+std::shared_ptr<Detection> DetectionPool::acquire(const Detection& value)
+{
+	for (size_t n = 0; n < _pool.size(); ++n) {
+		std::shared_ptr<Detection>& entry = _pool[_next];
+		_next = _next + 1 < _pool.size() ? _next + 1 : 0;
+
+		if (entry.use_count() == 1) {
+			// Pairs with the release of the last other owner, whose
+			// reads of the old value must not race with this write
+			std::atomic_thread_fence(std::memory_order_acquire);
+			*entry = value;
+			return entry;
+		}
+	}
+
+	_pool.push_back(std::make_shared<Detection>(value));
+	return _pool.back();
+}
+} // namespace peopleDetector
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Recycles the shared Detection objects handed to the tracker. A pooled
+ * detection is free again once the pool holds the only reference, i.e. the
+ * frame loop, the tracker and the track threads have all dropped it. The pool
+ * only grows while every entry is still in use, so after warm-up acquire()
+ * does not allocate.
+ */
+class DetectionPool
+{
+      public:
+	DetectionPool(size_t initialSize = 64);
+
+	/**< Shared copy of value, backed by a recycled entry when one is free */
+	std::shared_ptr<Detection> acquire(const Detection& value);
+
+	inline size_t size() const { return _pool.size(); }
+
+      private:
+	std::vector<std::shared_ptr<Detection>> _pool;
+	size_t _next = 0; // Round-robin scan start
+};
+} // namespace peopleDetector
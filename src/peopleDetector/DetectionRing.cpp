@@ -0,0 +1,62 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "DetectionRing.hpp"
+namespace peopleDetector
+{
+
+void DetectionRing::init(Detection* sets, uint32_t numSets, uint32_t setSize)
+{
+	_sets.clear();
+	_sets.reserve(numSets);
+	for (uint32_t i = 0; i < numSets; ++i)
+		_sets.emplace_back(sets + i * setSize, [](Detection*) {}); // The buffer belongs to the detector
+	_setSize = setSize;
+	_next = 0;
+}
+
+DetectionLease DetectionRing::tryLease()
+{
+	for (size_t n = 0; n < _sets.size(); ++n) {
+		DetectionLease& set = _sets[_next];
+		_next = _next + 1 < _sets.size() ? _next + 1 : 0;
+
+		if (set.use_count() == 1) {
+			// Pairs with the release of the last reader, whose reads of
+			// the old detections must not race with the detector's writes
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return set;
+		}
+	}
+	return nullptr;
+}
+
+DetectionLease DetectionRing::lease()
+{
+	DetectionLease set = tryLease();
+	if (set || _sets.empty())
+		return set;
+
+	++_waits;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_waitTimeoutMs);
+	while (std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::microseconds(_waitPollUs));
+		set = tryLease();
+		if (set)
+			return set;
+	}
+	++_timeouts;
+	return nullptr;
+}
+
+int DetectionRing::getLeased() const
+{
+	int leased = 0;
+	for (const DetectionLease& set : _sets) {
+		if (set.use_count() > 1)
+			++leased;
+	}
+	return leased;
+}
+} // namespace peopleDetector
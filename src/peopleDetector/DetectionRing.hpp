@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Ownership of one detection set in a DetectionRing: points at the set's
+ * first entry. Dropping the last copy (or every pointer derived from it with
+ * DetectionRing::share()) releases the set for reuse.
+ */
+using DetectionLease = std::shared_ptr<Detection>;
+
+/**
+ * Leases the detection sets of a detector's output ring (numSets buffers of
+ * setSize entries, e.g. mapped memory) instead of reusing them round-robin
+ * behind the readers' backs. Each set is held by a non-owning shared_ptr; a
+ * set is free again once the ring holds its only reference, so pipelined
+ * stages can keep pointers straight into the buffer for as long as they
+ * need, without copies. lease() waits while every set is held and gives up
+ * after _waitTimeoutMs, which pushes back on the detector instead of
+ * overwriting live detections. Leasing never allocates.
+ */
+class DetectionRing
+{
+      public:
+	// ################### Settings ###################
+	const int _waitTimeoutMs = 50; // Longest lease() blocks while every set is held
+	const int _waitPollUs = 200;
+	// ################################################
+
+	/**< Take over sets, which must outlive the ring and every lease */
+	void init(Detection* sets, uint32_t numSets, uint32_t setSize);
+
+	/**< Next free set, nullptr if none was released within _waitTimeoutMs */
+	DetectionLease lease();
+
+	/**< Entry n of a leased set, sharing the lease */
+	static inline std::shared_ptr<Detection> share(const DetectionLease& lease, int n)
+	{
+		return std::shared_ptr<Detection>(lease, lease.get() + n);
+	}
+
+	int getLeased() const; // Sets currently held outside the ring
+	inline uint64_t getWaits() const { return _waits; }
+	inline uint64_t getTimeouts() const { return _timeouts; }
+	inline uint32_t getSetSize() const { return _setSize; }
+
+      private:
+	DetectionLease tryLease();
+
+	std::vector<DetectionLease> _sets;
+	uint32_t _setSize = 0;
+	uint32_t _next = 0; // Round-robin scan start, keeps released sets unchanged for as long as possible
+	uint64_t _waits = 0;
+	uint64_t _timeouts = 0;
+};
+} // namespace peopleDetector
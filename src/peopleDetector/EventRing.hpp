@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace peopleDetector
+{
+
+/**
+ * Bounded lock-free multi-producer ring (Vyukov sequence-per-cell queue).
+ * Producers never block: when the ring is full the item is dropped and
+ * counted, so a slow consumer can only lose events, never stall a producer.
+ * Capacity must be a power of two.
+ */
+template <class T, size_t Capacity> class EventRing
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "EventRing capacity must be a power of two");
+
+      public:
+	EventRing()
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/**< Enqueue a copy of item, returns false (and counts a drop) if full */
+	bool push(const T& item)
+	{
+		size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;) {
+			cell = &_cells[pos & (Capacity - 1)];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			} else {
+				pos = _enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = item;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**< Dequeue into item, returns false if empty */
+	bool pop(T& item)
+	{
+		size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;) {
+			cell = &_cells[pos & (Capacity - 1)];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = _dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		item = cell->data;
+		cell->sequence.store(pos + Capacity, std::memory_order_release);
+		return true;
+	}
+
+	/**< Dequeue up to max items, returns the number taken */
+	size_t popBatch(T* items, size_t max)
+	{
+		size_t n = 0;
+		while (n < max && pop(items[n]))
+			++n;
+		return n;
+	}
+
+	inline uint64_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+	/**< Approximate number of queued items */
+	inline size_t getDepth() const
+	{
+		return _enqueuePos.load(std::memory_order_relaxed) - _dequeuePos.load(std::memory_order_relaxed);
+	}
+
+      private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	Cell _cells[Capacity];
+	alignas(64) std::atomic<size_t> _enqueuePos{0};
+	alignas(64) std::atomic<size_t> _dequeuePos{0};
+	alignas(64) std::atomic<uint64_t> _dropped{0};
+};
+} // namespace peopleDetector
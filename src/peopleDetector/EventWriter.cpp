@@ -0,0 +1,157 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <logging.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "AllocTracker.hpp"
+#include "EventWriter.hpp"
+#include "ThreadPolicy.hpp"
+namespace peopleDetector
+{
+
+static int64_t nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+EventWriter::EventWriter(CrossingEventRing& ring, const std::string& target) : _ring(ring), _target(target)
+{
+	const std::string prefix = "unix:";
+	if (_target.compare(0, prefix.size(), prefix) == 0)
+		_socketPath = _target.substr(prefix.size());
+	_buffer.reserve(_batchSize * 128);
+}
+
+EventWriter::~EventWriter() { stop(); }
+
+void EventWriter::start()
+{
+	if (_thread.joinable())
+		return;
+
+	if (_socketPath.empty()) {
+		_file = fopen(_target.c_str(), "a");
+		if (!_file) {
+			LogError("EventWriter -- failed to open %s\n", _target.c_str());
+			return;
+		}
+	}
+	_stop = false;
+	_thread = std::thread(&EventWriter::run, this);
+}
+
+void EventWriter::stop()
+{
+	_stop = true;
+	if (_thread.joinable())
+		_thread.join();
+	if (_file) {
+		fclose(_file);
+		_file = nullptr;
+	}
+	if (_socket >= 0) {
+		close(_socket);
+		_socket = -1;
+	}
+}
+
+bool EventWriter::connectSocket()
+{
+	if (_socket >= 0)
+		return true;
+	if (nowMs() < _nextConnectMs)
+		return false;
+	_nextConnectMs = nowMs() + _reconnectIntervalMs;
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, _socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+	_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (_socket < 0)
+		return false;
+	if (connect(_socket, (sockaddr*)&addr, sizeof(addr)) != 0) {
+		close(_socket);
+		_socket = -1;
+		return false;
+	}
+	fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL) | O_NONBLOCK);
+	LogVerbose("EventWriter -- connected to %s\n", _socketPath.c_str());
+	return true;
+}
+
+void EventWriter::writeBatch(const CrossingEvent* events, size_t n)
+{
+	_buffer.clear();
+	char line[160];
+	for (size_t i = 0; i < n; ++i) {
+		const CrossingEvent& e = events[i];
+		const int len = snprintf(line, sizeof(line), "{\"ts\":%lld,\"track\":%d,\"dir\":\"%s\",\"gate\":%d,\"class\":%u,\"conf\":%.3f}\n",
+					 (long long)e.timestampNs, e.trackId, e.direction == CrossingDirection::IN ? "in" : "out", e.gate,
+					 e.classId, e.confidence);
+		_buffer.append(line, len);
+	}
+
+	if (_file) {
+		fwrite(_buffer.data(), 1, _buffer.size(), _file);
+		fflush(_file);
+		_written += n;
+		return;
+	}
+
+	if (!connectSocket()) {
+		_dropped += n;
+		return;
+	}
+	size_t sent = 0;
+	int retries = 0;
+	while (sent < _buffer.size()) {
+		const ssize_t r = send(_socket, _buffer.data() + sent, _buffer.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (r > 0) {
+			sent += r;
+			continue;
+		}
+		if (r < 0 && errno == EINTR)
+			continue;
+		const bool wouldBlock = r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+		if (wouldBlock && sent > 0 && ++retries < 100) {
+			// Finish the partially sent line so the stream stays parseable
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		// Drop the batch; a hard error or a peer stalled mid-line needs a
+		// fresh connection
+		if (!wouldBlock || sent > 0) {
+			close(_socket);
+			_socket = -1;
+		}
+		_dropped += n;
+		return;
+	}
+	_written += n;
+}
+
+void EventWriter::run()
+{
+	ScopedThreadRole role(ThreadRole::OUTPUT, "events");
+	AllocTracker::excludeThread();
+	CrossingEvent batch[_batchSize];
+
+	for (;;) {
+		const bool stopping = _stop;
+		const size_t n = _ring.popBatch(batch, _batchSize);
+		if (n > 0) {
+			writeBatch(batch, n);
+			continue;
+		}
+		if (stopping)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(_idleSleepMs));
+	}
+}
+} // namespace peopleDetector
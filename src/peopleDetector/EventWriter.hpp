@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "CrossingEvent.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Background thread that drains a CrossingEventRing in batches and writes the
+ * events as JSON lines to a file, or to a Unix-domain stream socket when the
+ * target is given as "unix:/path/to/socket". Socket writes are non-blocking;
+ * a batch the peer cannot take right now is dropped and counted instead of
+ * backing up into the ring.
+ */
+class EventWriter
+{
+      public:
+	// ################### Settings ###################
+	static const size_t _batchSize = 64;
+	const int _idleSleepMs = 10;	     // Poll interval while the ring is empty
+	const int _reconnectIntervalMs = 1000; // Socket reconnect backoff
+	// ################################################
+
+	EventWriter(CrossingEventRing& ring, const std::string& target);
+	~EventWriter();
+
+	void start();
+	void stop(); // Drains what is left in the ring, then joins
+
+	inline uint64_t getWritten() const { return _written.load(std::memory_order_relaxed); }
+	inline uint64_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+      private:
+	void run();
+	void writeBatch(const CrossingEvent* events, size_t n);
+	bool connectSocket();
+
+	CrossingEventRing& _ring;
+	std::string _target;
+	std::string _socketPath;
+	std::string _buffer;
+	FILE* _file = nullptr;
+	int _socket = -1;
+	int64_t _nextConnectMs = 0;
+
+	std::thread _thread;
+	std::atomic<bool> _stop{false};
+	std::atomic<uint64_t> _written{0};
+	std::atomic<uint64_t> _dropped{0};
+};
+} // namespace peopleDetector
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <logging.h>
+#include <vector>
+
+#include "FrameTrace.hpp"
+namespace peopleDetector
+{
+
+FrameTrace::FrameTrace() {}
+
+uint32_t FrameTrace::threadId()
+{
+	static std::atomic<uint32_t> nextId{1};
+	thread_local uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+	return id;
+}
+
+void FrameTrace::record(const char* name, uint32_t frameId, int64_t startNs, int64_t endNs)
+{
+	const uint64_t index = _head.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = _slots[index % _capacity];
+
+	slot.stamp.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.span.startNs = startNs;
+	slot.span.durationNs = endNs - startNs;
+	slot.span.name = name;
+	slot.span.frameId = frameId;
+	slot.span.threadId = threadId();
+	slot.stamp.store(index + 1, std::memory_order_release);
+}
+
+bool FrameTrace::dump(const std::string& path) const
+{
+	const uint64_t head = _head.load(std::memory_order_acquire);
+	const uint64_t first = head > _capacity ? head - _capacity : 0;
+
+	std::vector<TraceSpan> spans;
+	spans.reserve(head - first);
+	for (uint64_t index = first; index < head; ++index) {
+		const Slot& slot = _slots[index % _capacity];
+		if (slot.stamp.load(std::memory_order_acquire) != index + 1)
+			continue;
+		const TraceSpan span = slot.span;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.stamp.load(std::memory_order_relaxed) != index + 1)
+			continue;
+		spans.push_back(span);
+	}
+
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		LogError("FrameTrace -- failed to open %s\n", path.c_str());
+		return false;
+	}
+
+	// Chrome trace timestamps are microseconds; keep them relative to the oldest span
+	int64_t originNs = spans.empty() ? 0 : spans.front().startNs;
+	for (const TraceSpan& span : spans)
+		originNs = span.startNs < originNs ? span.startNs : originNs;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < spans.size(); ++i) {
+		const TraceSpan& span = spans[i];
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}%s\n",
+			span.name, span.threadId, (span.startNs - originNs) / 1000.0, span.durationNs / 1000.0, span.frameId,
+			i + 1 < spans.size() ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	fclose(file);
+
+	LogInfo("FrameTrace -- wrote %zu spans to %s\n", spans.size(), path.c_str());
+	return true;
+}
+} // namespace peopleDetector
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace peopleDetector
+{
+
+struct TraceSpan {
+	int64_t startNs = 0; // steady_clock
+	int64_t durationNs = 0;
+	const char* name = nullptr; // String literal, never freed
+	uint32_t frameId = 0;
+	uint32_t threadId = 0;
+};
+
+/**
+ * Flight recorder for per-frame spans. record() claims a slot with one atomic
+ * add and overwrites the oldest span, so it is cheap enough to sit on the
+ * frame path of any thread. dump() writes the retained spans as Chrome trace
+ * JSON (chrome://tracing, ui.perfetto.dev); slots being rewritten while it
+ * runs are skipped.
+ */
+class FrameTrace
+{
+      public:
+	// ################### Settings ###################
+	static const size_t _capacity = 16384; // About a minute of spans at 30 fps
+	// ################################################
+
+	FrameTrace();
+
+	void record(const char* name, uint32_t frameId, int64_t startNs, int64_t endNs);
+	bool dump(const std::string& path) const;
+
+	static inline int64_t nowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+      private:
+	struct Slot {
+		std::atomic<uint64_t> stamp{0}; // Index + 1 once written, 0 while being written
+		TraceSpan span;
+	};
+
+	static uint32_t threadId();
+
+	Slot _slots[_capacity];
+	std::atomic<uint64_t> _head{0};
+};
+
+// Records the time from construction to destruction as a span
+class ScopedSpan
+{
+      public:
+	ScopedSpan(FrameTrace& trace, const char* name, uint32_t frameId)
+	    : _trace(trace), _name(name), _frameId(frameId), _start(FrameTrace::nowNs())
+	{
+	}
+	~ScopedSpan() { _trace.record(_name, _frameId, _start, FrameTrace::nowNs()); }
+
+      private:
+	FrameTrace& _trace;
+	const char* _name;
+	uint32_t _frameId;
+	int64_t _start;
+};
+} // namespace peopleDetector
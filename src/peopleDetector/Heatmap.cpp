@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdio>
+#include <logging.h>
+
+#include "AllocTracker.hpp"
+#include "Heatmap.hpp"
+#include "ThreadPolicy.hpp"
+namespace peopleDetector
+{
+
+Heatmap::Heatmap(int width, int height)
+    : _cols((width + _cellSize - 1) / _cellSize), _rows((height + _cellSize - 1) / _cellSize),
+      _cells(new std::atomic<uint32_t>[_cols * _rows]), _snapshot(_cols * _rows)
+{
+	reset();
+}
+
+Heatmap::~Heatmap() { stopExport(); }
+
+void Heatmap::add(float x, float y)
+{
+	// Predictions drift off screen while coasting; nobody stands there, so
+	// they must not pile up in the border cells
+	if (!(x >= 0 && y >= 0))
+		return;
+	const int col = (int)x / _cellSize;
+	const int row = (int)y / _cellSize;
+	if (col >= _cols || row >= _rows)
+		return;
+	_cells[row * _cols + col].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Heatmap::reset()
+{
+	for (int i = 0; i < _cols * _rows; ++i)
+		_cells[i].store(0, std::memory_order_relaxed);
+}
+
+bool Heatmap::exportTo(const std::string& path)
+{
+	HeatmapFileHeader header = {};
+	header.magic = kHeatmapMagic;
+	header.version = kHeatmapVersion;
+	header.cols = _cols;
+	header.rows = _rows;
+	header.cellSize = _cellSize;
+	header.wallTimeNs =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	for (size_t i = 0; i < _snapshot.size(); ++i) {
+		_snapshot[i] = _cells[i].load(std::memory_order_relaxed);
+		header.samples += _snapshot[i];
+	}
+
+	const std::string tmpPath = path + ".tmp";
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+	if (!file) {
+		LogError("Heatmap -- failed to open %s\n", tmpPath.c_str());
+		return false;
+	}
+	const bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			     fwrite(_snapshot.data(), sizeof(uint32_t), _snapshot.size(), file) == _snapshot.size();
+	if (fclose(file) != 0 || !written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+		LogError("Heatmap -- failed to write %s\n", path.c_str());
+		remove(tmpPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void Heatmap::startExport(const std::string& path, int intervalMs)
+{
+	if (_exportThread.joinable())
+		return;
+	_stopExport = false;
+	_exportThread = std::thread(&Heatmap::runExport, this, path, intervalMs);
+}
+
+void Heatmap::stopExport()
+{
+	{
+		std::lock_guard<std::mutex> lock(_exportMutex);
+		_stopExport = true;
+	}
+	_exportCond.notify_all();
+	if (_exportThread.joinable())
+		_exportThread.join();
+}
+
+void Heatmap::runExport(std::string path, int intervalMs)
+{
+	ScopedThreadRole role(ThreadRole::OUTPUT, "heatmap");
+	AllocTracker::excludeThread();
+	std::unique_lock<std::mutex> lock(_exportMutex);
+	for (;;) {
+		const bool stopping = _exportCond.wait_for(lock, std::chrono::milliseconds(intervalMs), [this] { return _stopExport; });
+		lock.unlock();
+		exportTo(path);
+		lock.lock();
+		if (stopping)
+			break;
+	}
+}
+} // namespace peopleDetector
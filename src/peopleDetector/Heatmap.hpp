@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace peopleDetector
+{
+
+static const uint32_t kHeatmapMagic = 0x4d484350; // "PCHM"
+static const uint32_t kHeatmapVersion = 1;
+
+// Header of an exported heatmap, followed by rows * cols little-endian
+// uint32 cell counts in row-major order
+struct HeatmapFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t cols;
+	uint32_t rows;
+	uint32_t cellSize; // Pixels per cell side
+	uint32_t reserved;
+	int64_t wallTimeNs; // system_clock time of the export
+	uint64_t samples;   // Sum of all cells
+};
+
+/**
+ * Coarse occupancy grid over the frame. Every live track adds its filtered
+ * position once per step from its own thread (a relaxed atomic increment);
+ * the cells are allocated once, so the memory cost is fixed by the frame
+ * size and _cellSize alone. Positions outside the frame are not counted.
+ * exportTo() writes a snapshot as a raw grid; startExport() does so
+ * periodically from a thread of its own, so the file I/O stays off the
+ * frame thread.
+ */
+class Heatmap
+{
+      public:
+	// ################### Settings ###################
+	const int _cellSize = 16; // Pixels per cell side, 80 x 45 cells for 1280 x 720
+	// ################################################
+
+	Heatmap(int width = 1280, int height = 720);
+	~Heatmap();
+
+	void add(float x, float y);
+	void reset();
+	bool exportTo(const std::string& path); // Written to path.tmp, then renamed into place
+	void startExport(const std::string& path, int intervalMs);
+	void stopExport(); // Exports a last time, then joins
+
+	inline int getCols() const { return _cols; }
+	inline int getRows() const { return _rows; }
+	inline uint32_t getCell(int col, int row) const { return _cells[row * _cols + col].load(std::memory_order_relaxed); }
+
+      private:
+	const int _cols;
+	const int _rows;
+	std::unique_ptr<std::atomic<uint32_t>[]> _cells;
+	std::vector<uint32_t> _snapshot; // Export buffer, sized once
+
+	void runExport(std::string path, int intervalMs);
+
+	std::thread _exportThread;
+	std::mutex _exportMutex;
+	std::condition_variable _exportCond;
+	bool _stopExport = false;
+};
+} // namespace peopleDetector
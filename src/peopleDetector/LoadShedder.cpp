@@ -0,0 +1,75 @@
+#include <logging.h>
+
+#include "Config.hpp"
+#include "LoadShedder.hpp"
+namespace peopleDetector
+{
+
+LoadShedder::LoadShedder(Metrics& metrics) : _metrics(metrics) {}
+
+void LoadShedder::frameCaptured(int64_t captureWaitNs)
+{
+	const int64_t now = FrameTrace::nowNs();
+	if (_expectedArrivalNs < 0 || captureWaitNs >= _freshWaitNs)
+		_expectedArrivalNs = now;
+	else
+		_expectedArrivalNs += _framePeriodNs;
+
+	// The clock runs ahead when the camera delivers slower than its
+	// nominal rate, never let it claim a frame from the future
+	if (_expectedArrivalNs > now)
+		_expectedArrivalNs = now;
+	_captureAgeNs = now - _expectedArrivalNs;
+
+	const int64_t budgetNs = currentConfig().latencyBudgetMs * 1000000;
+	_dropped = _captureAgeNs > budgetNs;
+	++_frames;
+}
+
+bool LoadShedder::dropFrame()
+{
+	if (_dropped)
+		++_metrics.droppedFrames;
+	return _dropped;
+}
+
+bool LoadShedder::skipInference()
+{
+	const bool skip = !_dropped && _level >= ShedLevel::SKIP_INFERENCE && (_frames & 1);
+	if (skip)
+		++_metrics.skippedInference;
+	return skip;
+}
+
+bool LoadShedder::skipOverlay()
+{
+	const bool skip = !_dropped && _level >= ShedLevel::SKIP_OVERLAY;
+	if (skip)
+		++_metrics.skippedOverlay;
+	return skip || _dropped;
+}
+
+void LoadShedder::frameDone()
+{
+	const int64_t ageNs = FrameTrace::nowNs() - _expectedArrivalNs;
+	_metrics.frameAge.record(ageNs);
+
+	const float budgetNs = currentConfig().latencyBudgetMs * 1e6f;
+	_smoothedRatio += 0.1f * (ageNs / budgetNs - _smoothedRatio);
+	const uint64_t held = _frames - _lastChange;
+
+	ShedLevel level = _level;
+	if (_smoothedRatio > _escalateRatio && _level < ShedLevel::SKIP_INFERENCE && held >= (uint64_t)_escalateHoldFrames)
+		level = (ShedLevel)((int)_level + 1);
+	else if (_smoothedRatio < _relaxRatio && _level > ShedLevel::NONE && held >= (uint64_t)_relaxHoldFrames)
+		level = (ShedLevel)((int)_level - 1);
+	if (level == _level)
+		return;
+
+	LogInfo("LoadShedder -- frame age %.0f%% of the budget, shed level %i -> %i\n", _smoothedRatio * 100, (int)_level, (int)level);
+	_level = level;
+	_lastChange = _frames;
+	_metrics.shedLevel.store((int)level, std::memory_order_relaxed);
+	++_metrics.shedLevelChanges;
+}
+} // namespace peopleDetector
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Metrics.hpp"
+
+namespace peopleDetector
+{
+
+// What the frame loop leaves out of the current frame
+enum class ShedLevel : int {
+	NONE = 0,
+	SKIP_OVERLAY,	// No boxes or labels drawn
+	SKIP_INFERENCE, // Inference on every second frame only, overlay still off
+	COUNT
+};
+
+/**
+ * Keeps the live count within the latency budget (Config::latencyBudgetMs)
+ * when the loop cannot keep up, e.g. under thermal throttling.
+ *
+ * The camera does not timestamp frames, so the age of a frame is estimated
+ * from an arrival clock: a Capture() that had to wait got a fresh frame
+ * and resets the clock, one that returned at once got a buffered frame that
+ * arrived one frame period after the previous one. A frame older than the
+ * budget is dropped (no inference, no overlay); the tracker still takes a
+ * step without detections, so dropped frames count as elapsed time and the
+ * tracks coast across them. Completed frames drive the shed level with
+ * hysteresis: the overlay goes first, then inference on alternate frames.
+ * Every decision is counted in Metrics.
+ */
+class LoadShedder
+{
+      public:
+	// ################### Settings ###################
+	const int64_t _framePeriodNs = 1000000000 / 30; // Camera frame rate
+	const int64_t _freshWaitNs = 2000000;	       // A capture that waited this long got a fresh frame
+	const float _escalateRatio = 0.8f;	       // Completion age / budget that raises the level
+	const float _relaxRatio = 0.4f;		       // ... and that lowers it again
+	const int _escalateHoldFrames = 30;	       // Minimum frames before raising the level again
+	const int _relaxHoldFrames = 300;	       // ... and before lowering it, so it does not flap
+	// ################################################
+
+	LoadShedder(Metrics& metrics);
+
+	/**< Call after each successful capture with the time Capture() blocked */
+	void frameCaptured(int64_t captureWaitNs);
+
+	/**< Decisions for the captured frame, each counted when it sheds something */
+	bool dropFrame();
+	bool skipInference();
+	bool skipOverlay();
+
+	/**< Call when the frame's count is published, updates the level */
+	void frameDone();
+
+	inline ShedLevel getLevel() const { return _level; }
+	inline int64_t getFrameAgeNs() const { return _captureAgeNs; }
+
+      private:
+	Metrics& _metrics;
+	int64_t _expectedArrivalNs = -1; // Estimated arrival time of the current frame
+	int64_t _captureAgeNs = 0;
+	bool _dropped = false;
+	uint64_t _frames = 0;
+	uint64_t _lastChange = 0;
+	float _smoothedRatio = 0.0f;
+	ShedLevel _level = ShedLevel::NONE;
+};
+} // namespace peopleDetector
@@ -0,0 +1,159 @@
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedVideoSource.hpp"
+namespace peopleDetector
+{
+
+static const char kY4mMagic[] = "YUV4MPEG2 ";
+
+MappedVideoSource::~MappedVideoSource() { close(); }
+
+bool MappedVideoSource::open(const std::string& path, uint32_t width, uint32_t height)
+{
+	close();
+
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		LogError("MappedVideoSource -- failed to open %s\n", path.c_str());
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		LogError("MappedVideoSource -- %s is empty\n", path.c_str());
+		::close(fd);
+		return false;
+	}
+	void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		LogError("MappedVideoSource -- failed to map %s\n", path.c_str());
+		return false;
+	}
+	madvise(mem, st.st_size, MADV_SEQUENTIAL);
+	_map = (uint8_t*)mem;
+	_mapSize = st.st_size;
+
+	const bool y4m = _mapSize > sizeof(kY4mMagic) && memcmp(_map, kY4mMagic, sizeof(kY4mMagic) - 1) == 0;
+	if (y4m) {
+		if (!parseY4m(path)) {
+			close();
+			return false;
+		}
+	} else {
+		if (width == 0 || height == 0) {
+			LogError("MappedVideoSource -- %s is raw RGB8, the frame size is needed\n", path.c_str());
+			close();
+			return false;
+		}
+		_width = width;
+		_height = height;
+		_format = PixelFormat::RGB8;
+		const size_t frameSize = pixelFormatSize(_format, width, height);
+		if (_mapSize % frameSize != 0)
+			LogError("MappedVideoSource -- %s ends with a partial frame, ignoring it\n", path.c_str());
+		for (size_t offset = 0; offset + frameSize <= _mapSize; offset += frameSize)
+			_frames.push_back(offset);
+	}
+
+	LogInfo("MappedVideoSource -- %s: %u frames of %ux%u %s\n", path.c_str(), getFrameCount(), _width, _height,
+		_format == PixelFormat::I420 ? "I420" : "RGB8");
+	return !_frames.empty();
+}
+
+bool MappedVideoSource::parseY4m(const std::string& path)
+{
+	// Stream header: "YUV4MPEG2 W<w> H<h> [F<n>:<d>] [C<colourspace>] ...\n"
+	const uint8_t* end = (const uint8_t*)memchr(_map, '\n', _mapSize);
+	if (!end) {
+		LogError("MappedVideoSource -- %s: truncated Y4M header\n", path.c_str());
+		return false;
+	}
+	std::string header((const char*)_map, end - _map);
+	size_t pos = 0;
+	while (pos < header.size()) {
+		size_t next = header.find(' ', pos);
+		if (next == std::string::npos)
+			next = header.size();
+		const std::string token = header.substr(pos, next - pos);
+		pos = next + 1;
+		if (token.empty())
+			continue;
+
+		switch (token[0]) {
+		case 'W':
+			_width = strtoul(token.c_str() + 1, nullptr, 10);
+			break;
+		case 'H':
+			_height = strtoul(token.c_str() + 1, nullptr, 10);
+			break;
+		case 'F': {
+			char* colon = nullptr;
+			const float numerator = strtof(token.c_str() + 1, &colon);
+			const float denominator = *colon == ':' ? strtof(colon + 1, nullptr) : 1.0f;
+			_frameRate = denominator > 0 ? numerator / denominator : 0.0f;
+			break;
+		}
+		case 'C':
+			if (token.compare(0, 4, "C420") != 0) {
+				LogError("MappedVideoSource -- %s: unsupported colourspace %s, only 4:2:0\n", path.c_str(), token.c_str());
+				return false;
+			}
+			break;
+		}
+	}
+	if (_width == 0 || _height == 0) {
+		LogError("MappedVideoSource -- %s: Y4M header without a frame size\n", path.c_str());
+		return false;
+	}
+	_format = PixelFormat::I420;
+
+	// Every frame is "FRAME[ params]\n" followed by the planes
+	const size_t frameSize = pixelFormatSize(_format, _width, _height);
+	size_t offset = end - _map + 1;
+	while (offset + 5 < _mapSize && memcmp(_map + offset, "FRAME", 5) == 0) {
+		const uint8_t* lineEnd = (const uint8_t*)memchr(_map + offset, '\n', _mapSize - offset);
+		if (!lineEnd)
+			break;
+		const size_t pixels = lineEnd - _map + 1;
+		if (pixels + frameSize > _mapSize) {
+			LogError("MappedVideoSource -- %s ends with a partial frame, ignoring it\n", path.c_str());
+			break;
+		}
+		_frames.push_back(pixels);
+		offset = pixels + frameSize;
+	}
+	return true;
+}
+
+void MappedVideoSource::close()
+{
+	if (_map)
+		munmap(_map, _mapSize);
+	_map = nullptr;
+	_mapSize = 0;
+	_frames.clear();
+	_next = 0;
+}
+
+bool MappedVideoSource::next(VideoFrame& frame)
+{
+	if (_next >= _frames.size()) {
+		if (!_loop || _frames.empty())
+			return false;
+		_next = 0;
+	}
+	frame.data = _map + _frames[_next];
+	frame.format = _format;
+	frame.width = _width;
+	frame.height = _height;
+	frame.index = _next;
+	++_next;
+	return true;
+}
+} // namespace peopleDetector
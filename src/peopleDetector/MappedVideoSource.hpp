@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TensorNorm.hpp"
+
+namespace peopleDetector
+{
+
+// One frame handed out by MappedVideoSource, pointing into the mapping
+struct VideoFrame {
+	const uint8_t* data;
+	PixelFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t index;
+};
+
+/**
+ * Frame source for benchmarks without a camera. Memory-maps a raw video
+ * file read-only and hands out pointers straight into the mapping, so
+ * capture costs no copies; pages are faulted in on first access and read
+ * ahead sequentially. Two layouts are supported:
+ *  - .y4m (YUV4MPEG2) with 4:2:0 chroma, size and frame rate from the header
+ *  - raw interleaved RGB8 frames back to back, size given to open()
+ */
+class MappedVideoSource
+{
+      public:
+	~MappedVideoSource();
+
+	/**< Map path; width and height are only needed for raw RGB8 files */
+	bool open(const std::string& path, uint32_t width = 0, uint32_t height = 0);
+	void close();
+
+	/**< Next frame, false after the last one unless looping */
+	bool next(VideoFrame& frame);
+	inline void rewind() { _next = 0; }
+	inline void setLoop(bool loop) { _loop = loop; }
+
+	inline uint32_t getWidth() const { return _width; }
+	inline uint32_t getHeight() const { return _height; }
+	inline PixelFormat getFormat() const { return _format; }
+	inline uint32_t getFrameCount() const { return _frames.size(); }
+	inline float getFrameRate() const { return _frameRate; } // 0 if the file does not say
+
+      private:
+	bool parseY4m(const std::string& path);
+
+	uint8_t* _map = nullptr;
+	size_t _mapSize = 0;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	PixelFormat _format = PixelFormat::RGB8;
+	float _frameRate = 0.0f;
+	std::vector<size_t> _frames; // Offset of each frame's pixels in the mapping
+	uint32_t _next = 0;
+	bool _loop = false;
+};
+} // namespace peopleDetector
@@ -0,0 +1,71 @@
+#include "Metrics.hpp"
+namespace peopleDetector
+{
+
+const uint32_t LatencyHistogram::bucketBoundsUs[numBuckets] = {50,    100,   200,    500,    1000,   2000,    5000,      10000,
+							       20000, 50000, 100000, 200000, 500000, 1000000, 0xFFFFFFFF};
+
+const char* stageName(Stage stage)
+{
+	switch (stage) {
+	case Stage::CAPTURE:
+		return "capture";
+	case Stage::DETECT:
+		return "detect";
+	case Stage::TRACK:
+		return "track";
+	case Stage::OUTPUT:
+		return "output";
+	case Stage::FRAME:
+		return "frame";
+	default:
+		return "unknown";
+	}
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+	const uint64_t us = ns / 1000;
+	int b = 0;
+	while (b < numBuckets - 1 && us > bucketBoundsUs[b])
+		++b;
+	_buckets[b].fetch_add(1, std::memory_order_relaxed);
+	_sumUs.fetch_add(us, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset()
+{
+	for (int b = 0; b < numBuckets; ++b)
+		_buckets[b].store(0, std::memory_order_relaxed);
+	_sumUs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+	uint64_t n = 0;
+	for (int b = 0; b < numBuckets; ++b)
+		n += _buckets[b].load(std::memory_order_relaxed);
+	return n;
+}
+
+uint32_t LatencyHistogram::percentileUs(double q) const
+{
+	uint64_t counts[numBuckets];
+	uint64_t total = 0;
+	for (int b = 0; b < numBuckets; ++b) {
+		counts[b] = _buckets[b].load(std::memory_order_relaxed);
+		total += counts[b];
+	}
+	if (total == 0)
+		return 0;
+
+	const uint64_t rank = (uint64_t)(q * total + 0.5);
+	uint64_t seen = 0;
+	for (int b = 0; b < numBuckets; ++b) {
+		seen += counts[b];
+		if (seen >= rank && seen > 0)
+			return bucketBoundsUs[b];
+	}
+	return bucketBoundsUs[numBuckets - 1];
+}
+} // namespace peopleDetector
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "AllocTracker.hpp"
+#include "FrameTrace.hpp"
+
+namespace peopleDetector
+{
+
+enum class Stage : int { CAPTURE = 0, DETECT, TRACK, OUTPUT, FRAME, COUNT };
+
+const char* stageName(Stage stage);
+
+/**
+ * Fixed-bucket latency histogram. record() is a relaxed atomic increment so
+ * it can sit on the frame path; percentiles are derived by the reader.
+ */
+class LatencyHistogram
+{
+      public:
+	static const int numBuckets = 15;
+	static const uint32_t bucketBoundsUs[numBuckets]; // Upper bounds, last is open
+
+	void record(uint64_t ns);
+	void reset();
+	uint64_t getCount() const;
+	uint64_t getSumUs() const { return _sumUs.load(std::memory_order_relaxed); }
+
+	/**< Upper bound (us) of the bucket holding quantile q of the samples */
+	uint32_t percentileUs(double q) const;
+
+      private:
+	std::atomic<uint64_t> _buckets[numBuckets] = {};
+	std::atomic<uint64_t> _sumUs{0};
+};
+
+/**
+ * Values exported by the metrics endpoint. The frame loop publishes with
+ * relaxed atomic stores, MetricsServer only ever loads.
+ */
+class Metrics
+{
+      public:
+	inline void observe(Stage stage, uint64_t ns) { _latency[(int)stage].record(ns); }
+	inline const LatencyHistogram& latency(Stage stage) const { return _latency[(int)stage]; }
+
+	// Heap allocations made by the frame loop thread inside a stage, only
+	// non-zero in PEOPLECOUNTER_ALLOC_TRACKING builds
+	inline void observeAllocations(Stage stage, uint64_t n) { _allocations[(int)stage].fetch_add(n, std::memory_order_relaxed); }
+	inline uint64_t getAllocations(Stage stage) const { return _allocations[(int)stage].load(std::memory_order_relaxed); }
+
+	std::atomic<uint64_t> frames{0};
+	std::atomic<uint64_t> skippedFrames{0};
+	std::atomic<int> liveTracks{0};
+	std::atomic<float> networkFps{0.0f};
+	std::atomic<uint64_t> eventQueueDepth{0};
+	std::atomic<uint64_t> eventsDropped{0};
+	std::atomic<uint64_t> allocationRegressions{0}; // Steady-state frames that allocated
+
+	// Load shedding decisions (LoadShedder)
+	LatencyHistogram frameAge; // Estimated capture-to-publish age of each frame
+	std::atomic<int> shedLevel{0};
+	std::atomic<uint64_t> shedLevelChanges{0};
+	std::atomic<uint64_t> droppedFrames{0}; // Stale frames only stepped the tracker
+	std::atomic<uint64_t> skippedInference{0};
+	std::atomic<uint64_t> skippedOverlay{0};
+
+	// Detector output sets held by later stages (DetectionRing)
+	std::atomic<int> leasedDetectionSets{0};
+	std::atomic<uint64_t> detectionLeaseWaits{0};	 // Frames that waited for a set
+	std::atomic<uint64_t> detectionLeaseTimeouts{0}; // Frames that got none
+
+      private:
+	LatencyHistogram _latency[(int)Stage::COUNT];
+	std::atomic<uint64_t> _allocations[(int)Stage::COUNT] = {};
+};
+
+// Records the time (and allocations) from construction to destruction into
+// a stage histogram, and as a span of frameId when a trace is given
+class StageTimer
+{
+      public:
+	// startNs backdates the stage, e.g. a frame to its capture; < 0 starts now
+	StageTimer(Metrics& metrics, Stage stage, FrameTrace* trace = nullptr, uint32_t frameId = 0, int64_t startNs = -1)
+	    : _metrics(metrics), _stage(stage), _trace(trace), _frameId(frameId), _start(startNs < 0 ? FrameTrace::nowNs() : startNs),
+	      _allocations(AllocTracker::getThreadAllocations())
+	{
+	}
+	~StageTimer()
+	{
+		const int64_t end = FrameTrace::nowNs();
+		_metrics.observe(_stage, end - _start);
+		_metrics.observeAllocations(_stage, AllocTracker::getThreadAllocations() - _allocations);
+		if (_trace)
+			_trace->record(stageName(_stage), _frameId, _start, end);
+	}
+
+      private:
+	Metrics& _metrics;
+	Stage _stage;
+	FrameTrace* _trace;
+	uint32_t _frameId;
+	int64_t _start;
+	uint64_t _allocations;
+};
+} // namespace peopleDetector
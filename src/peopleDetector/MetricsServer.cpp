@@ -0,0 +1,195 @@
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <logging.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "AllocTracker.hpp"
+#include "MetricsServer.hpp"
+#include "ThreadPolicy.hpp"
+namespace peopleDetector
+{
+
+MetricsServer::MetricsServer(const Metrics& metrics, const Counter& counter, const std::string& target)
+    : _metrics(metrics), _counter(counter), _target(target)
+{
+	_body.reserve(4096);
+	_response.reserve(4096);
+}
+
+MetricsServer::~MetricsServer() { stop(); }
+
+bool MetricsServer::start()
+{
+	const std::string prefix = "unix:";
+	if (_target.compare(0, prefix.size(), prefix) == 0) {
+		const std::string path = _target.substr(prefix.size());
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		unlink(path.c_str());
+
+		_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (_listen < 0 || bind(_listen, (sockaddr*)&addr, sizeof(addr)) != 0) {
+			LogError("MetricsServer -- failed to bind %s\n", path.c_str());
+			stop();
+			return false;
+		}
+	} else {
+		const size_t colon = _target.rfind(':');
+		const std::string host = colon == std::string::npos ? "127.0.0.1" : _target.substr(0, colon);
+		const int port = atoi(colon == std::string::npos ? _target.c_str() : _target.c_str() + colon + 1);
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+
+		_listen = socket(AF_INET, SOCK_STREAM, 0);
+		const int one = 1;
+		setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (_listen < 0 || bind(_listen, (sockaddr*)&addr, sizeof(addr)) != 0) {
+			LogError("MetricsServer -- failed to bind %s\n", _target.c_str());
+			stop();
+			return false;
+		}
+	}
+
+	if (listen(_listen, 4) != 0) {
+		LogError("MetricsServer -- failed to listen on %s\n", _target.c_str());
+		stop();
+		return false;
+	}
+
+	LogInfo("MetricsServer -- serving metrics on %s\n", _target.c_str());
+	_stop = false;
+	_thread = std::thread(&MetricsServer::run, this);
+	return true;
+}
+
+void MetricsServer::stop()
+{
+	_stop = true;
+	if (_thread.joinable())
+		_thread.join();
+	if (_listen >= 0) {
+		close(_listen);
+		_listen = -1;
+	}
+}
+
+void MetricsServer::run()
+{
+	ScopedThreadRole role(ThreadRole::OUTPUT, "metrics");
+	AllocTracker::excludeThread();
+	while (!_stop) {
+		pollfd pfd = {_listen, POLLIN, 0};
+		if (poll(&pfd, 1, 200) <= 0)
+			continue;
+		const int client = accept(_listen, nullptr, nullptr);
+		if (client < 0)
+			continue;
+		serve(client);
+		close(client);
+	}
+}
+
+void MetricsServer::serve(int client)
+{
+	// The request itself is irrelevant, every path returns the metrics.
+	// Wait briefly for it so the client does not see a reset.
+	char request[1024];
+	pollfd pfd = {client, POLLIN, 0};
+	if (poll(&pfd, 1, 500) > 0)
+		recv(client, request, sizeof(request), 0);
+
+	_body.clear();
+	render(_body);
+
+	char header[128];
+	const int len = snprintf(header, sizeof(header),
+				 "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", _body.size());
+	_response.assign(header, len);
+	_response += _body;
+
+	size_t sent = 0;
+	while (sent < _response.size()) {
+		const ssize_t r = send(client, _response.data() + sent, _response.size() - sent, MSG_NOSIGNAL);
+		if (r <= 0)
+			break;
+		sent += r;
+	}
+}
+
+static void appendMetric(std::string& out, const char* name, const char* type, double value)
+{
+	char line[256];
+	snprintf(line, sizeof(line), "# TYPE %s %s\n%s %g\n", name, type, name, value);
+	out += line;
+}
+
+void MetricsServer::render(std::string& out) const
+{
+	appendMetric(out, "peoplecounter_status", "gauge", _counter.getStatus());
+	appendMetric(out, "peoplecounter_entered_total", "counter", _counter.getEntered());
+	appendMetric(out, "peoplecounter_left_total", "counter", _counter.getLeft());
+	appendMetric(out, "peoplecounter_network_fps", "gauge", _metrics.networkFps.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_live_tracks", "gauge", _metrics.liveTracks.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_frames_total", "counter", _metrics.frames.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_skipped_frames_total", "counter", _metrics.skippedFrames.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_event_queue_depth", "gauge", _metrics.eventQueueDepth.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_events_dropped_total", "counter", _metrics.eventsDropped.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_shed_level", "gauge", _metrics.shedLevel.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_shed_level_changes_total", "counter", _metrics.shedLevelChanges.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_dropped_frames_total", "counter", _metrics.droppedFrames.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_skipped_inference_total", "counter", _metrics.skippedInference.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_skipped_overlay_total", "counter", _metrics.skippedOverlay.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_leased_detection_sets", "gauge", _metrics.leasedDetectionSets.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_detection_lease_waits_total", "counter", _metrics.detectionLeaseWaits.load(std::memory_order_relaxed));
+	appendMetric(out, "peoplecounter_detection_lease_timeouts_total", "counter",
+		     _metrics.detectionLeaseTimeouts.load(std::memory_order_relaxed));
+
+	char line[256];
+	out += "# TYPE peoplecounter_stage_latency_us summary\n";
+	for (int s = 0; s < (int)Stage::COUNT; ++s) {
+		const LatencyHistogram& h = _metrics.latency((Stage)s);
+		const char* name = stageName((Stage)s);
+		const double quantiles[] = {0.5, 0.9, 0.99};
+		for (double q : quantiles) {
+			snprintf(line, sizeof(line), "peoplecounter_stage_latency_us{stage=\"%s\",quantile=\"%g\"} %u\n", name, q,
+				 h.percentileUs(q));
+			out += line;
+		}
+		snprintf(line, sizeof(line), "peoplecounter_stage_latency_us_sum{stage=\"%s\"} %llu\n", name, (unsigned long long)h.getSumUs());
+		out += line;
+		snprintf(line, sizeof(line), "peoplecounter_stage_latency_us_count{stage=\"%s\"} %llu\n", name, (unsigned long long)h.getCount());
+		out += line;
+	}
+
+	out += "# TYPE peoplecounter_frame_age_us summary\n";
+	for (double q : {0.5, 0.9, 0.99}) {
+		snprintf(line, sizeof(line), "peoplecounter_frame_age_us{quantile=\"%g\"} %u\n", q, _metrics.frameAge.percentileUs(q));
+		out += line;
+	}
+	snprintf(line, sizeof(line), "peoplecounter_frame_age_us_sum %llu\npeoplecounter_frame_age_us_count %llu\n",
+		 (unsigned long long)_metrics.frameAge.getSumUs(), (unsigned long long)_metrics.frameAge.getCount());
+	out += line;
+
+	if (!AllocTracker::enabled())
+		return;
+	appendMetric(out, "peoplecounter_allocations_total", "counter", AllocTracker::getAllocations());
+	appendMetric(out, "peoplecounter_allocated_bytes_total", "counter", AllocTracker::getBytes());
+	appendMetric(out, "peoplecounter_allocation_regressions_total", "counter", _metrics.allocationRegressions.load(std::memory_order_relaxed));
+	out += "# TYPE peoplecounter_stage_allocations_total counter\n";
+	for (int s = 0; s < (int)Stage::COUNT; ++s) {
+		snprintf(line, sizeof(line), "peoplecounter_stage_allocations_total{stage=\"%s\"} %llu\n", stageName((Stage)s),
+			 (unsigned long long)_metrics.getAllocations((Stage)s));
+		out += line;
+	}
+}
+} // namespace peopleDetector
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "Counter.hpp"
+#include "Metrics.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Minimal HTTP endpoint serving Metrics and Counter values in the Prometheus
+ * text format. Listens on "unix:/path" or "host:port" (localhost only is
+ * intended) and handles one request at a time on its own thread; it only
+ * loads atomics, so scraping never blocks the frame loop.
+ */
+class MetricsServer
+{
+      public:
+	MetricsServer(const Metrics& metrics, const Counter& counter, const std::string& target);
+	~MetricsServer();
+
+	bool start();
+	void stop();
+
+      private:
+	void run();
+	void serve(int client);
+	void render(std::string& out) const;
+
+	const Metrics& _metrics;
+	const Counter& _counter;
+	std::string _target;
+	std::string _body; // Reused between scrapes
+	std::string _response;
+	int _listen = -1;
+
+	std::thread _thread;
+	std::atomic<bool> _stop{false};
+};
+} // namespace peopleDetector
@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdlib>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "MotionGate.hpp"
+namespace peopleDetector
+{
+
+// Count samples whose absolute difference to the background exceeds the
+// threshold and move the background towards the current samples by
+// 1 / 2^shift. The background is kept in fixed point with 7 fractional
+// bits, so even a slow update converges to the scene instead of stalling
+// on rounding.
+static int diffAndUpdate(const uint8_t* current, int16_t* background, size_t n, uint8_t threshold, int shift)
+{
+	size_t i = 0;
+	int changed = 0;
+
+#if defined(__aarch64__)
+	const uint8x16_t thr = vdupq_n_u8(threshold);
+	const int16x8_t negShift = vdupq_n_s16(-shift);
+	for (; i + 16 <= n; i += 16) {
+		const uint8x16_t c = vld1q_u8(current + i);
+		int16x8_t lo = vld1q_s16(background + i);
+		int16x8_t hi = vld1q_s16(background + i + 8);
+		const uint8x16_t b = vcombine_u8(vqrshrun_n_s16(lo, 7), vqrshrun_n_s16(hi, 7));
+		const uint8x16_t mask = vcgtq_u8(vabdq_u8(c, b), thr);
+		changed += vaddlvq_u8(vshrq_n_u8(mask, 7));
+
+		const int16x8_t cLo = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(c), 7));
+		const int16x8_t cHi = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(c), 7));
+		lo = vaddq_s16(lo, vshlq_s16(vsubq_s16(cLo, lo), negShift));
+		hi = vaddq_s16(hi, vshlq_s16(vsubq_s16(cHi, hi), negShift));
+		vst1q_s16(background + i, lo);
+		vst1q_s16(background + i + 8, hi);
+	}
+#elif defined(__SSE2__)
+	const __m128i thr = _mm_set1_epi8((char)threshold);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi16(64);
+	const __m128i count = _mm_cvtsi32_si128(shift);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)(current + i));
+		__m128i lo = _mm_loadu_si128((const __m128i*)(background + i));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(background + i + 8));
+		const __m128i b = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(lo, half), 7), _mm_srai_epi16(_mm_add_epi16(hi, half), 7));
+		const __m128i diff = _mm_or_si128(_mm_subs_epu8(c, b), _mm_subs_epu8(b, c));
+		const __m128i unchanged = _mm_cmpeq_epi8(_mm_subs_epu8(diff, thr), zero);
+		changed += 16 - __builtin_popcount(_mm_movemask_epi8(unchanged));
+
+		const __m128i cLo = _mm_slli_epi16(_mm_unpacklo_epi8(c, zero), 7);
+		const __m128i cHi = _mm_slli_epi16(_mm_unpackhi_epi8(c, zero), 7);
+		lo = _mm_add_epi16(lo, _mm_sra_epi16(_mm_sub_epi16(cLo, lo), count));
+		hi = _mm_add_epi16(hi, _mm_sra_epi16(_mm_sub_epi16(cHi, hi), count));
+		_mm_storeu_si128((__m128i*)(background + i), lo);
+		_mm_storeu_si128((__m128i*)(background + i + 8), hi);
+	}
+#endif
+	for (; i < n; ++i) {
+		const int b = (background[i] + 64) >> 7;
+		if (std::abs(current[i] - b) > threshold)
+			++changed;
+		background[i] += ((current[i] << 7) - background[i]) >> shift;
+	}
+	return changed;
+}
+
+void MotionGate::resize(uint32_t width, uint32_t height)
+{
+	_width = width;
+	_height = height;
+	_cols = (width + _sampleStep - 1) / _sampleStep;
+	_rows = (height + _sampleStep - 1) / _sampleStep;
+	_current.assign(_cols * _rows, 0);
+	_background.assign(_cols * _rows, 0);
+	_hasBackground = false;
+}
+
+void MotionGate::sample(const uint8_t* rgb, uint32_t width)
+{
+	const size_t rowStride = (size_t)width * 3 * _sampleStep;
+	const size_t colStride = 3 * _sampleStep;
+	uint8_t* out = _current.data();
+
+	for (uint32_t r = 0; r < _rows; ++r) {
+		const uint8_t* px = rgb + r * rowStride;
+		for (uint32_t c = 0; c < _cols; ++c, px += colStride) {
+			// Integer luma approximation (R + 2G + B) / 4
+			*out++ = (px[0] + 2 * px[1] + px[2]) >> 2;
+		}
+	}
+}
+
+bool MotionGate::hasMotion(const void* image, uint32_t width, uint32_t height)
+{
+	if (!image || width == 0 || height == 0)
+		return true;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	if (width != _width || height != _height)
+		resize(width, height);
+
+	sample((const uint8_t*)image, width);
+
+	bool motion;
+	if (!_hasBackground) {
+		for (size_t i = 0; i < _current.size(); ++i)
+			_background[i] = _current[i] << 7;
+		_hasBackground = true;
+		_changedSamples = 0;
+		motion = true;
+	} else {
+		_changedSamples = diffAndUpdate(_current.data(), _background.data(), _current.size(), _pixelThreshold, _backgroundShift);
+		motion = _changedSamples >= _minChangedFraction * _current.size();
+	}
+
+	if (motion)
+		_framesSinceMotion = 0;
+	else if (_framesSinceMotion <= _holdFrames)
+		++_framesSinceMotion;
+
+	const auto end = std::chrono::steady_clock::now();
+	_lastCostUs = std::chrono::duration<float, std::micro>(end - start).count();
+
+	return _framesSinceMotion <= _holdFrames;
+}
+} // namespace peopleDetector
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace peopleDetector
+{
+
+/**
+ * Cheap CPU pre-stage that decides whether a frame is worth running the
+ * detection network on. The frame is point-sampled into a small luma image
+ * which is compared against a running background model; if not enough of the
+ * samples changed the frame is considered static and inference can be skipped.
+ */
+class MotionGate
+{
+      public:
+	// ################### Settings ###################
+	const int _sampleStep = 4;		   // Sample every n-th pixel in x and y
+	const uint8_t _pixelThreshold = 25;	   // Luma difference for a sample to count as changed
+	const float _minChangedFraction = 0.002f; // Fraction of changed samples that counts as motion
+	const int _holdFrames = 15;		   // Keep detecting this many frames after the last motion
+	const int _backgroundShift = 5;		   // Background moves 1/32 towards each frame, about a second at 30 fps
+	// ################################################
+
+	MotionGate() = default;
+
+	/**
+	 * Return true if the RGB8 frame differs enough from the background model
+	 * (or motion was seen within the last _holdFrames frames).
+	 */
+	bool hasMotion(const void* image, uint32_t width, uint32_t height);
+
+	inline int getChangedSamples() const { return _changedSamples; }
+	inline float getLastCostUs() const { return _lastCostUs; }
+
+      private:
+	void resize(uint32_t width, uint32_t height);
+	void sample(const uint8_t* rgb, uint32_t width);
+
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	uint32_t _cols = 0;
+	uint32_t _rows = 0;
+	bool _hasBackground = false;
+	int _framesSinceMotion = 0;
+	int _changedSamples = 0;
+	float _lastCostUs = 0.0f;
+
+	std::vector<uint8_t> _current;	  // Downsampled luma of the current frame
+	std::vector<int16_t> _background; // Running background model, luma << 7
+};
+} // namespace peopleDetector
@@ -1,7 +1,10 @@
 #include "PeopleDetector.hpp"
+#include "Config.hpp"
+#include "cudaCrop.h"
 #include "cudaDraw.h"
 #include "cudaFont.h"
 #include "cudaMappedMemory.h"
+#include <algorithm>
 #include <jetson-utils/filesystem.h>
 #include <jetson-utils/logging.h>
 
@@ -27,7 +30,6 @@ PeopleDetector::PeopleDetector(float meanPixel) : tensorNet()
 
 	detectionSets_[0] = NULL; // cpu ptr
 	detectionSets_[1] = NULL; // gpu ptr
-	detectionSet_ = 0;
 	maxDetections_ = 0;
 }
 
@@ -47,6 +49,11 @@ PeopleDetector::~PeopleDetector()
 		classColors_[0] = NULL;
 		classColors_[1] = NULL;
 	}
+
+	if (tileBuffer_ != NULL) {
+		CUDA(cudaFreeHost(tileBuffer_));
+		tileBuffer_ = NULL;
+	}
 }
 std::unique_ptr<PeopleDetector> PeopleDetector::Create(const std::string model)
 {
@@ -136,6 +143,7 @@ bool PeopleDetector::allocDetections()
 		return false;
 
 	memset(detectionSets_[0], 0, det_size);
+	detectionRing_.init(detectionSets_[0], numDetectionSets_, maxDetections_);
 	return true;
 }
 
@@ -149,9 +157,26 @@ bool PeopleDetector::loadClassInfo(const char* filename)
 
 	LogInfo(LOG_TRT "PeopleDetector -- number of object classes:  %u\n", numClasses_);
 	classPath_ = locateFile(filename);
+	updateClassMask(currentConfig());
 	return true;
 }
 
+// updateClassMask
+void PeopleDetector::updateClassMask(const Config& config)
+{
+	// Keyed on the selection, not the snapshot address: a replaced snapshot
+	// is freed after the grace period and a later one may reuse its address
+	if (classMaskCompiled_ && classMaskSelection_ == config.countedClasses)
+		return;
+	classMaskCompiled_ = true;
+	classMaskSelection_ = config.countedClasses;
+
+	if (!classMask_.compile(config.countedClasses, classDesc_))
+		LogError(LOG_TRT "PeopleDetector -- no valid class in '%s', nothing will be counted\n", config.countedClasses.c_str());
+	for (int slot = 0; slot < classMask_.size(); ++slot)
+		LogInfo(LOG_TRT "PeopleDetector -- counting class %u (%s)\n", classMask_.getClassId(slot), GetClassDesc(classMask_.getClassId(slot)));
+}
+
 // LoadClassInfo
 bool PeopleDetector::LoadClassInfo(const char* filename, std::vector<std::string>& descriptions, std::vector<std::string>& synsets,
 				   int expectedClasses)
@@ -310,20 +335,73 @@ void PeopleDetector::GenerateColor(uint32_t classID, uint8_t* rgb)
 }
 
 // Detect
-int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFormat format, Detection** detections, uint32_t overlay)
+int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFormat format, DetectionLease& lease, uint32_t overlay)
 {
-	Detection* det = detectionSets_[0] + detectionSet_ * GetMaxDetections();
+	lease = detectionRing_.lease();
+	if (!lease) {
+		LogError(LOG_TRT "PeopleDetector::Detect() -- all %u detection sets are still leased\n", numDetectionSets_);
+		return -1;
+	}
 
-	if (detections != NULL)
-		*detections = det;
+	return Detect(input, width, height, format, lease.get(), overlay);
+}
+// DetectTiles
+int PeopleDetector::DetectTiles(void* input, uint32_t width, uint32_t height, imageFormat format, const float* predictions, int numPredictions,
+				DetectionLease& lease)
+{
+	lease = detectionRing_.lease();
+	if (!lease) {
+		LogError(LOG_TRT "PeopleDetector::DetectTiles() -- all %u detection sets are still leased\n", numDetectionSets_);
+		return -1;
+	}
+
+	const int numTiles = planner_.plan(width, height, currentConfig().countingLineX, predictions, numPredictions, tiles_);
+	if (tileDetections_.size() < numTiles * GetMaxDetections())
+		tileDetections_.resize(numTiles * GetMaxDetections());
 
-	detectionSet_++;
+	int numDetections = 0;
+	for (int t = 0; t < numTiles; ++t) {
+		const Tile& tile = tiles_[t];
+		void* source = input;
+		if (t > 0) {
+			const size_t size = imageFormatSize(format, tile.width(), tile.height());
+			if (size > tileBufferSize_) {
+				if (tileBuffer_ != NULL)
+					CUDA(cudaFreeHost(tileBuffer_));
+				tileBuffer_ = NULL;
+				tileBufferSize_ = 0;
+				if (!cudaAllocMapped(&tileBuffer_, size)) {
+					LogError(LOG_TRT "PeopleDetector::DetectTiles() -- failed to allocate the crop buffer\n");
+					break;
+				}
+				tileBufferSize_ = size;
+			}
+			if (CUDA_FAILED(cudaCrop(input, tileBuffer_, make_int4(tile.left, tile.top, tile.right, tile.bottom), width, height, format,
+						 GetStream()))) {
+				LogError(LOG_TRT "PeopleDetector::DetectTiles() -- cudaCrop() failed\n");
+				continue;
+			}
+			source = tileBuffer_;
+		}
 
-	if (detectionSet_ >= numDetectionSets_)
-		detectionSet_ = 0;
+		Detection* tileDetections = tileDetections_.data() + numDetections;
+		const int n = Detect(source, tile.width(), tile.height(), format, tileDetections, 0);
+		for (int i = 0; i < n; ++i) {
+			tileDetections[i].Left += tile.left;
+			tileDetections[i].Right += tile.left;
+			tileDetections[i].Top += tile.top;
+			tileDetections[i].Bottom += tile.top;
+		}
+		if (n > 0)
+			numDetections += n;
+	}
 
-	return Detect(input, width, height, format, det, overlay);
+	numDetections = std::min<int>(planner_.merge(tileDetections_.data(), numDetections), GetMaxDetections());
+	std::copy(tileDetections_.begin(), tileDetections_.begin() + numDetections, lease.get());
+	LogVerbose(LOG_TRT "PeopleDetector::DetectTiles() -- %i detections from %i tiles\n", numDetections, numTiles);
+	return numDetections;
 }
+
 // Detect
 int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFormat format, Detection* detections, uint32_t overlay)
 {
@@ -370,24 +448,34 @@ int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFo
 	LogDebug(LOG_TRT "PeopleDetector::Detect() -- %i unfiltered detections\n", rawDetections);
 #endif
 
+	batch_.clear();
+
+	const Config& config = currentConfig();
+	const float threshold = config.coverageThreshold >= 0 ? config.coverageThreshold : coverageThreshold_;
+	updateClassMask(config);
+
 	// filter the raw detections by thresholding the confidence and choose only
-	// person class
+	// the counted classes, "void" labels never have a slot
 	for (int n = 0; n < rawDetections; n++) {
 		float* object_data = mOutputs[OUTPUT_UFF].CPU + n * rawParameters;
 
-		uint32_t classId = object_data[1];
-		if (classId != 1)
-			continue; // beacause classId = 1 only for pedestrian
-		if (object_data[2] < coverageThreshold_)
+		const uint32_t classId = object_data[1];
+		const int classSlot = classMask_.slot(classId);
+		if (classSlot < 0)
+			continue;
+		if (object_data[2] < threshold)
 			continue;
 
 		detections[numDetections].Instance = numDetections; //(uint32_t)object_data[0];
-		detections[numDetections].ClassID = (uint32_t)object_data[1];
+		detections[numDetections].ClassID = classId;
+		detections[numDetections].classSlot = classSlot;
 		detections[numDetections].Confidence = object_data[2];
 		detections[numDetections].Left = object_data[3] * width;
 		detections[numDetections].Top = object_data[4] * height;
 		detections[numDetections].Right = object_data[5] * width;
 		detections[numDetections].Bottom = object_data[6] * height;
+		detections[numDetections].associated = false; // leased sets come back with the tracker's marks
+		detections[numDetections].trackId = -1;
 
 		if (detections[numDetections].ClassID >= numClasses_) {
 			LogError(LOG_TRT "PeopleDetector::Detect() -- detected object has invalid "
@@ -402,9 +490,6 @@ int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFo
 		LogVerbose(LOG_TRT "detections[%i].Right = %f\n", numDetections, detections[numDetections].Right);
 		LogVerbose(LOG_TRT "detections[%i].Bottom = %f\n", numDetections, detections[numDetections].Bottom);
 
-		if (strcmp(GetClassDesc(detections[numDetections].ClassID), "void") == 0)
-			continue;
-
 		numDetections += clusterDetections(detections, numDetections);
 	}
 
@@ -433,7 +518,7 @@ int PeopleDetector::Detect(void* input, uint32_t width, uint32_t height, imageFo
 }
 
 void PeopleDetector::UpdateVisuals(void* input, uint32_t width, uint32_t height, imageFormat format, int numDetections,
-				    std::vector<std::shared_ptr<Detection>> detections, uint32_t overlay)
+				    const std::vector<std::shared_ptr<Detection>>& detections, uint32_t overlay)
 {
 	// render the overlay
 	if (overlay != 0 && numDetections > 0) {
@@ -442,7 +527,8 @@ void PeopleDetector::UpdateVisuals(void* input, uint32_t width, uint32_t height,
 	}
 	// drawLine
 	const float4 lineColor = {255, 255, 255, 123};
-	cudaDrawLine(input, input, width, height, format, 640, 0, 640, height, lineColor, lineWidth_);
+	const float countingLineX = currentConfig().countingLineX;
+	cudaDrawLine(input, input, width, height, format, countingLineX, 0, countingLineX, height, lineColor, lineWidth_);
 
 	const int2 txtPos = make_int2(5, 5);
 	char txt[256];
@@ -454,9 +540,11 @@ void PeopleDetector::UpdateVisuals(void* input, uint32_t width, uint32_t height,
 		font = cudaFont::Create(adaptFontSize(width));
 	}
 
-	std::vector<std::pair<std::string, int2>> labels;
-	labels.push_back(std::pair<std::string, int2>(txt, txtPos));
-	font->OverlayText(input, format, width, height, labels, make_float4(255, 255, 255, 255));
+	if (statusLabel_.empty())
+		statusLabel_.resize(1);
+	statusLabel_[0].first.assign(txt);
+	statusLabel_[0].second = txtPos;
+	font->OverlayText(input, format, width, height, statusLabel_, make_float4(255, 255, 255, 255));
 
 	// wait for GPU to complete work
 	CUDA(cudaDeviceSynchronize());
@@ -465,13 +553,17 @@ void PeopleDetector::UpdateVisuals(void* input, uint32_t width, uint32_t height,
 // clusterDetections (UFF/ONNX)
 int PeopleDetector::clusterDetections(Detection* detections, int n, float threshold)
 {
+	batch_.push(detections[n]);
+
 	if (n == 0)
 		return 1;
 
-	// test each detection to see if it intersects
+	// test the new detection against all kept ones at once
+	overlap_.resize(n);
+	batch_.overlapRatios(detections[n].Left, detections[n].Top, detections[n].Right, detections[n].Bottom, n, overlap_.data());
+
 	for (int m = 0; m < n; m++) {
-		if (detections[n].Intersects(detections[m],
-					     threshold)) // TODO NMS or different threshold for same classes?
+		if (overlap_[m] > threshold) // TODO NMS or different threshold for same classes?
 		{
 			if (detections[n].ClassID != detections[m].ClassID) {
 				if (detections[n].Confidence > detections[m].Confidence) {
@@ -486,6 +578,8 @@ int PeopleDetector::clusterDetections(Detection* detections, int n, float thresh
 				detections[m].Confidence = fmaxf(detections[n].Confidence, detections[m].Confidence);
 			}
 
+			batch_.setBox(m, detections[m].Left, detections[m].Top, detections[m].Right, detections[m].Bottom);
+			batch_.resize(n);
 			return 0; // merged detection
 		}
 	}
@@ -519,11 +613,11 @@ void PeopleDetector::sortDetections(Detection* detections, int numDetections)
 
 // from detectNet.cu
 cudaError_t cudaDetectionOverlay(void* input, void* output, uint32_t width, uint32_t height, imageFormat format,
-				 std::vector<std::shared_ptr<Detection>> detections, int numDetections, float4* colors);
+				 const std::vector<std::shared_ptr<Detection>>& detections, int numDetections, float4* colors);
 
 // Overlay
 bool PeopleDetector::Overlay(void* input, void* output, uint32_t width, uint32_t height, imageFormat format,
-			     std::vector<std::shared_ptr<Detection>> detections, uint32_t numDetections, uint32_t flags)
+			     const std::vector<std::shared_ptr<Detection>>& detections, uint32_t numDetections, uint32_t flags)
 {
 	PROFILER_BEGIN(PROFILER_VISUALIZE);
 
@@ -586,14 +680,17 @@ bool PeopleDetector::Overlay(void* input, void* output, uint32_t width, uint32_t
 			}
 		}
 
-		// draw each object's description
-		std::vector<std::pair<std::string, int2>> labels;
+		// draw each object's description. The label strings are kept
+		// between frames (unused ones are cleared) so they stop allocating
+		// once they have grown to the longest text.
+		if (labels_.size() < numDetections)
+			labels_.resize(numDetections);
 
 		for (uint32_t n = 0; n < numDetections; n++) {
-			std::string className = GetClassDesc(detections[n]->ClassID);
+			char className[128];
+			snprintf(className, sizeof(className), "%s %u", GetClassDesc(detections[n]->ClassID), detections[n]->Instance);
 			const float confidence = detections[n]->Confidence * 100.0f;
 			const int trackId = detections[n]->trackId;
-			className = className + " " + std::to_string(detections[n]->Instance);
 			const int2 position = make_int2(detections[n]->Left + 5, detections[n]->Top + 3);
 
 			if (flags & detectNet::OVERLAY_CONFIDENCE) {
@@ -601,22 +698,25 @@ bool PeopleDetector::Overlay(void* input, void* output, uint32_t width, uint32_t
 
 				if ((flags & detectNet::OVERLAY_LABEL) && (flags & detectNet::OVERLAY_CONFIDENCE))
 					if (trackId >= 0)
-						//sprintf(str, "ID = %i %s %.1f%% ", trackId, className.c_str(), confidence);
+						//sprintf(str, "ID = %i %s %.1f%% ", trackId, className, confidence);
 						sprintf(str, "ID = %i", trackId);
 
 					else
-						sprintf(str, "%s %.1f%% ", className.c_str(), confidence);
+						sprintf(str, "%s %.1f%% ", className, confidence);
 				else
 					sprintf(str, "%.1f%%", confidence);
 
-				labels.push_back(std::pair<std::string, int2>(str, position));
+				labels_[n].first.assign(str);
 			} else {
 				// overlay label only
-				labels.push_back(std::pair<std::string, int2>(className, position));
+				labels_[n].first.assign(className);
 			}
+			labels_[n].second = position;
 		}
+		for (size_t n = numDetections; n < labels_.size(); n++)
+			labels_[n].first.clear();
 
-		font->OverlayText(output, format, width, height, labels, make_float4(255, 255, 255, 255));
+		font->OverlayText(output, format, width, height, labels_, make_float4(255, 255, 255, 255));
 	}
 
 	PROFILER_END(PROFILER_VISUALIZE);
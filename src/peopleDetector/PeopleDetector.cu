@@ -90,7 +90,7 @@ __global__ void gpuDetectionOverlayBox(T* input, T* output, int imgWidth, int im
 }
 
 template <typename T>
-cudaError_t launchDetectionOverlay(T* input, T* output, uint32_t width, uint32_t height, std::vector<std::shared_ptr<Detection>> detections,
+cudaError_t launchDetectionOverlay(T* input, T* output, uint32_t width, uint32_t height, const std::vector<std::shared_ptr<Detection>>& detections,
 				   int numDetections, float4* colors)
 {
 	if (!input || !output || width == 0 || height == 0 || detections.empty() || numDetections == 0 || !colors)
@@ -117,7 +117,7 @@ cudaError_t launchDetectionOverlay(T* input, T* output, uint32_t width, uint32_t
 }
 
 cudaError_t cudaDetectionOverlay(void* input, void* output, uint32_t width, uint32_t height, imageFormat format,
-				 std::vector<std::shared_ptr<Detection>> detections, int numDetections, float4* colors)
+				 const std::vector<std::shared_ptr<Detection>>& detections, int numDetections, float4* colors)
 {
 	if (format == IMAGE_RGB8)
 		return launchDetectionOverlay<uchar3>((uchar3*)input, (uchar3*)output, width, height, detections, numDetections, colors);
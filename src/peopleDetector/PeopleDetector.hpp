@@ -1,7 +1,12 @@
 #pragma once
 
+#include "ClassMask.hpp"
+#include "Config.hpp"
 #include "Counter.hpp"
 #include "Detection.hpp"
+#include "DetectionBatch.hpp"
+#include "DetectionRing.hpp"
+#include "TilePlanner.hpp"
 #include <jetson-inference/detectNet.h>
 #include <jetson-inference/tensorConvert.h>
 #include <jetson-inference/tensorNet.h>
@@ -37,21 +42,41 @@ class PeopleDetector : public tensorNet
 	int Detect(void* input, uint32_t width, uint32_t height, imageFormat format, Detection* detections,
 		   uint32_t overlay = detectNet::OVERLAY_DEFAULT);
 
+	/**
+	 * Detect into a set leased from the output ring, see DetectionRing.
+	 * The set stays valid and unchanged until lease and every pointer
+	 * shared from it are dropped. Returns -1 if every set is still held.
+	 */
 	template <typename T>
-	int Detect(T* image, uint32_t width, uint32_t height, Detection** detections, uint32_t overlay = detectNet::OVERLAY_DEFAULT)
+	int Detect(T* image, uint32_t width, uint32_t height, DetectionLease& lease, uint32_t overlay = detectNet::OVERLAY_DEFAULT)
 	{
-		return Detect((void*)image, width, height, imageFormatFromType<T>(), detections, overlay);
+		return Detect((void*)image, width, height, imageFormatFromType<T>(), lease, overlay);
 	}
 
-	int Detect(void* input, uint32_t width, uint32_t height, imageFormat format, Detection** detections, uint32_t overlay);
+	int Detect(void* input, uint32_t width, uint32_t height, imageFormat format, DetectionLease& lease, uint32_t overlay);
+
+	/**
+	 * Detect on the full frame plus crops along the counting line and
+	 * around the predicted track positions (xy pairs, see TilePlanner),
+	 * merged with cross-tile NMS. For wide-angle views where far-field
+	 * people shrink below the network's input resolution; costs one extra
+	 * network pass per crop.
+	 */
+	template <typename T>
+	int DetectTiles(T* image, uint32_t width, uint32_t height, const float* predictions, int numPredictions, DetectionLease& lease)
+	{
+		return DetectTiles((void*)image, width, height, imageFormatFromType<T>(), predictions, numPredictions, lease);
+	}
+	int DetectTiles(void* input, uint32_t width, uint32_t height, imageFormat format, const float* predictions, int numPredictions,
+			DetectionLease& lease);
 	template <typename T>
-	void UpdateVisuals(T* input, uint32_t width, uint32_t height, int numDetections, std::vector<std::shared_ptr<Detection>> detections,
+	void UpdateVisuals(T* input, uint32_t width, uint32_t height, int numDetections, const std::vector<std::shared_ptr<Detection>>& detections,
 			    uint32_t overlay = detectNet::OVERLAY_DEFAULT)
 	{
 		UpdateVisuals((void*)input, width, height, imageFormatFromType<T>(), numDetections, detections);
 	}
 	void UpdateVisuals(void* input, uint32_t width, uint32_t height, imageFormat format, int numDetections,
-			    std::vector<std::shared_ptr<Detection>> detections, uint32_t overlay = detectNet::OVERLAY_DEFAULT);
+			    const std::vector<std::shared_ptr<Detection>>& detections, uint32_t overlay = detectNet::OVERLAY_DEFAULT);
 	inline void setThreshold(float threshold) { coverageThreshold_ = threshold; }
 
 	/**
@@ -84,15 +109,17 @@ class PeopleDetector : public tensorNet
 	 * memory.
 	 */
 	bool Overlay(void* input, void* output, uint32_t width, uint32_t height, imageFormat format,
-		     std::vector<std::shared_ptr<Detection>> detections, uint32_t numDetections, uint32_t flags = detectNet::OVERLAY_DEFAULT);
+		     const std::vector<std::shared_ptr<Detection>>& detections, uint32_t numDetections, uint32_t flags = detectNet::OVERLAY_DEFAULT);
 
 	inline uint32_t GetMaxDetections() const { return maxDetections_; }
+	inline const DetectionRing& GetDetectionRing() const { return detectionRing_; }
 	inline void setCounter(Counter& setCounter) { counter = &setCounter; }
 
       protected:
 	bool allocDetections();
 	bool defaultColors();
 	bool loadClassInfo(const char* filename);
+	void updateClassMask(const Config& config); // Recompile classMask_ if the class selection changed
 	int clusterDetections(Detection* detections, int n, float threshold = DETECTOR_DEFAULT_THRESHOLD);
 	// bool isIndoor(Detection& detection);
 	void sortDetections(Detection* detections, int numDetections);
@@ -105,12 +132,24 @@ class PeopleDetector : public tensorNet
 	std::vector<std::string> classSynset_;
 	std::string classPath_;
 	uint32_t numClasses_;
+	ClassMask classMask_;			 // class id -> tally slot, compiled from Config::countedClasses
+	std::string classMaskSelection_;	 // selection classMask_ was compiled from
+	bool classMaskCompiled_ = false;
 
 	Detection* detectionSets_[2];		      // list of detections, detectionSets_ *
 						      // maxDetections_
-	uint32_t detectionSet_;			      // index of next detection set to use
+	DetectionRing detectionRing_;		      // leases of the sets in detectionSets_
 	uint32_t maxDetections_;		      // number of raw detections in the grid
 	static const uint32_t numDetectionSets_ = 16; // size of detection ringbuffer
+	DetectionBatch batch_;			      // SoA copy of the boxes kept during clustering
+	std::vector<float> overlap_;		      // scratch for batch_.overlapRatios()
+	TilePlanner planner_;			      // crops and cross-tile NMS of DetectTiles()
+	Tile tiles_[TilePlanner::maxPlannedTiles];
+	std::vector<Detection> tileDetections_; // all crops' detections in frame coordinates
+	void* tileBuffer_ = nullptr;		 // mapped memory for one crop
+	size_t tileBufferSize_ = 0;
+	std::vector<std::pair<std::string, int2>> labels_;	     // overlay text, reused between frames
+	std::vector<std::pair<std::string, int2>> statusLabel_; // counter status line
 	Counter* counter;
 };
 } // namespace peopleDetector
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace peopleDetector
+{
+
+// Name of the POSIX shared-memory segment holding the live counts
+#define PEOPLECOUNTER_SHM_NAME "/peoplecounter"
+
+static const uint32_t kSharedCountsMagic = 0x50434e54; // "PCNT"
+static const uint32_t kSharedCountsVersion = 1;
+static const int kSharedMaxGates = 8;
+static const int kSharedMaxZones = 8;
+
+struct SharedGateCounts {
+	int32_t entered;
+	int32_t left;
+};
+
+struct SharedZoneCounts {
+	int32_t occupancy;
+};
+
+// Consistent snapshot of the counter state as seen by readers. Gate 0 is the
+// counting line the totals come from, further gates are the configured
+// gateLines. Zone 0 is the area behind the counting line (the net count),
+// further zones hold the tracks inside the configured zones.
+struct SharedCounts {
+	int64_t timestampNs; // Wall clock of the publication
+	uint64_t frameId;
+	int32_t status;
+	int32_t entered;
+	int32_t left;
+	uint32_t numGates;
+	SharedGateCounts gates[kSharedMaxGates];
+	uint32_t numZones;
+	SharedZoneCounts zones[kSharedMaxZones];
+};
+
+/**
+ * Memory layout of the segment. The single writer bumps sequence to an odd
+ * value, copies the payload and bumps it to the next even value; a reader
+ * copies the payload between two loads of sequence and retries if they
+ * differ or are odd. The sequence never decreases, also across writer
+ * restarts.
+ */
+struct SharedCountsSegment {
+	uint32_t magic;
+	uint32_t version;
+	alignas(64) std::atomic<uint32_t> sequence;
+	alignas(64) SharedCounts data;
+};
+} // namespace peopleDetector
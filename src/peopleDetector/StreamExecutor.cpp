@@ -0,0 +1,51 @@
+#include "StreamExecutor.hpp"
+namespace peopleDetector
+{
+
+StreamExecutor::StreamExecutor(WorkStealingPool& pool) : _pool(pool) {}
+
+int StreamExecutor::addStream()
+{
+	_streams.emplace_back(new Stream);
+	return _streams.size() - 1;
+}
+
+void StreamExecutor::submit(int streamIndex, int frameId, DetectionVec detections)
+{
+	Stream& stream = *_streams[streamIndex];
+	{
+		std::lock_guard<std::mutex> lock(stream.mutex);
+		stream.frames.push_back({frameId, std::move(detections)});
+		if (stream.scheduled)
+			return; // The running drain task picks it up
+		stream.scheduled = true;
+	}
+	_pool.submit([this, &stream] { drain(stream); });
+}
+
+void StreamExecutor::drain(Stream& stream)
+{
+	Frame frame;
+	for (int n = 0; n < _framesPerTask; ++n) {
+		{
+			std::lock_guard<std::mutex> lock(stream.mutex);
+			if (stream.frames.empty()) {
+				stream.scheduled = false;
+				return;
+			}
+			frame = std::move(stream.frames.front());
+			stream.frames.pop_front();
+		}
+
+		stream.tracker.setNewDetections(frame.frameId, frame.detections);
+		stream.tracker.associate();
+		stream.tracker.createNewTracks();
+		stream.framesProcessed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Yield to the other streams, still scheduled so ordering is kept.
+	// A plain submit() would land on top of this worker's deque and be
+	// taken again right away.
+	_pool.requeue([this, &stream] { drain(stream); });
+}
+} // namespace peopleDetector
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Counter.hpp"
+#include "Tracker.hpp"
+#include "WorkStealingPool.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Runs the tracking step of many camera streams on a shared
+ * WorkStealingPool. Each stream owns a synchronous Tracker and a Counter;
+ * submitted frames of a stream are processed strictly in order and never
+ * on two workers at once, while different streams run in parallel. A
+ * stream is queued as at most one task at a time, which drains up to
+ * _framesPerTask frames and then requeues itself behind the tasks already
+ * waiting (WorkStealingPool::requeue), so a busy entrance cannot hold a
+ * worker while quieter streams wait.
+ */
+class StreamExecutor
+{
+      public:
+	// ################### Settings ###################
+	const int _framesPerTask = 4;
+	// ################################################
+
+	using DetectionVec = Tracker::DetectionVec;
+
+	StreamExecutor(WorkStealingPool& pool);
+
+	/**< Add a stream, returns its index. All streams must be added before the first submit() */
+	int addStream();
+
+	/**< Queue one frame of a stream */
+	void submit(int stream, int frameId, DetectionVec detections);
+
+	/**< Block until every submitted frame has been processed */
+	inline void wait() { _pool.wait(); }
+
+	inline int getStreamCount() const { return _streams.size(); }
+	inline const Counter& getCounter(int stream) const { return _streams[stream]->counter; }
+	inline uint64_t getFramesProcessed(int stream) const { return _streams[stream]->framesProcessed.load(std::memory_order_relaxed); }
+
+	/**< Only while the stream is idle (after wait()) */
+	inline Tracker& getTracker(int stream) { return _streams[stream]->tracker; }
+
+      private:
+	struct Frame {
+		int frameId;
+		DetectionVec detections;
+	};
+
+	struct Stream {
+		Stream() : tracker(counter, true) {}
+
+		Counter counter;
+		Tracker tracker;
+
+		std::mutex mutex; // Guards frames and scheduled
+		std::deque<Frame> frames;
+		bool scheduled = false; // A drain task is queued or running
+		std::atomic<uint64_t> framesProcessed{0};
+	};
+
+	void drain(Stream& stream);
+
+	WorkStealingPool& _pool;
+	std::vector<std::unique_ptr<Stream>> _streams;
+};
+} // namespace peopleDetector
@@ -0,0 +1,139 @@
+#include <algorithm>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "TensorNorm.hpp"
+namespace peopleDetector
+{
+
+size_t pixelFormatSize(PixelFormat format, uint32_t width, uint32_t height)
+{
+	if (format == PixelFormat::I420)
+		return (size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+	return (size_t)width * height * 3;
+}
+
+// out[i] = in[i] * scale + offset for n bytes
+static void normalise(const uint8_t* in, float* out, size_t n, float scale, float offset)
+{
+	size_t i = 0;
+
+#if defined(__aarch64__)
+	const float32x4_t s = vdupq_n_f32(scale);
+	const float32x4_t o = vdupq_n_f32(offset);
+	for (; i + 16 <= n; i += 16) {
+		const uint8x16_t px = vld1q_u8(in + i);
+		const uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+		const uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+		vst1q_f32(out + i, vmlaq_f32(o, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), s));
+		vst1q_f32(out + i + 4, vmlaq_f32(o, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), s));
+		vst1q_f32(out + i + 8, vmlaq_f32(o, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), s));
+		vst1q_f32(out + i + 12, vmlaq_f32(o, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), s));
+	}
+#elif defined(__SSE2__)
+	const __m128 s = _mm_set1_ps(scale);
+	const __m128 o = _mm_set1_ps(offset);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16) {
+		const __m128i px = _mm_loadu_si128((const __m128i*)(in + i));
+		const __m128i lo = _mm_unpacklo_epi8(px, zero);
+		const __m128i hi = _mm_unpackhi_epi8(px, zero);
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), s), o));
+		_mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s), o));
+		_mm_storeu_ps(out + i + 8, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s), o));
+		_mm_storeu_ps(out + i + 12, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s), o));
+	}
+#endif
+	for (; i < n; ++i)
+		out[i] = in[i] * scale + offset;
+}
+
+static inline uint8_t clampByte(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+void CpuTensorNorm::resize(uint32_t width, uint32_t height, uint32_t outputWidth, uint32_t outputHeight)
+{
+	_width = width;
+	_height = height;
+	_outputWidth = outputWidth;
+	_outputHeight = outputHeight;
+
+	// Same sampling as the CUDA kernel: source = (int)(x * width / outputWidth)
+	const float scaleX = (float)width / outputWidth;
+	const float scaleY = (float)height / outputHeight;
+	_sourceX.resize(outputWidth);
+	for (uint32_t x = 0; x < outputWidth; ++x)
+		_sourceX[x] = std::min((uint32_t)(x * scaleX), width - 1);
+	_sourceY.resize(outputHeight);
+	for (uint32_t y = 0; y < outputHeight; ++y)
+		_sourceY[y] = std::min((uint32_t)(y * scaleY), height - 1);
+	_row.resize(3 * outputWidth);
+}
+
+void CpuTensorNorm::gatherRGB8(const uint8_t* rgb, uint32_t width, uint32_t y)
+{
+	const uint8_t* line = rgb + (size_t)_sourceY[y] * width * 3;
+	uint8_t* b = _row.data();
+	uint8_t* g = b + _outputWidth;
+	uint8_t* r = g + _outputWidth;
+	for (uint32_t x = 0; x < _outputWidth; ++x) {
+		const uint8_t* px = line + _sourceX[x] * 3;
+		r[x] = px[0];
+		g[x] = px[1];
+		b[x] = px[2];
+	}
+}
+
+void CpuTensorNorm::gatherI420(const uint8_t* yuv, uint32_t width, uint32_t height, uint32_t y)
+{
+	const uint32_t chromaWidth = (width + 1) / 2;
+	const uint32_t chromaHeight = (height + 1) / 2;
+	const uint32_t sy = _sourceY[y];
+	const uint8_t* lumaLine = yuv + (size_t)sy * width;
+	const uint8_t* uLine = yuv + (size_t)width * height + (size_t)(sy / 2) * chromaWidth;
+	const uint8_t* vLine = uLine + (size_t)chromaWidth * chromaHeight;
+	uint8_t* b = _row.data();
+	uint8_t* g = b + _outputWidth;
+	uint8_t* r = g + _outputWidth;
+
+	// BT.601 limited range, 8-bit fixed point
+	for (uint32_t x = 0; x < _outputWidth; ++x) {
+		const uint32_t sx = _sourceX[x];
+		const int c = 298 * (lumaLine[sx] - 16);
+		const int d = uLine[sx / 2] - 128;
+		const int e = vLine[sx / 2] - 128;
+		r[x] = clampByte((c + 409 * e + 128) >> 8);
+		g[x] = clampByte((c - 100 * d - 208 * e + 128) >> 8);
+		b[x] = clampByte((c + 516 * d + 128) >> 8);
+	}
+}
+
+bool CpuTensorNorm::normBGR(const void* input, PixelFormat format, uint32_t width, uint32_t height, float* output, uint32_t outputWidth,
+			    uint32_t outputHeight, float rangeMin, float rangeMax)
+{
+	if (!input || !output || width == 0 || height == 0 || outputWidth == 0 || outputHeight == 0)
+		return false;
+
+	if (width != _width || height != _height || outputWidth != _outputWidth || outputHeight != _outputHeight)
+		resize(width, height, outputWidth, outputHeight);
+
+	const float scale = (rangeMax - rangeMin) / 255.0f;
+	const size_t plane = (size_t)outputWidth * outputHeight;
+	const uint8_t* pixels = (const uint8_t*)input;
+
+	for (uint32_t y = 0; y < outputHeight; ++y) {
+		if (format == PixelFormat::I420)
+			gatherI420(pixels, width, height, y);
+		else
+			gatherRGB8(pixels, width, y);
+
+		float* out = output + (size_t)y * outputWidth;
+		for (int channel = 0; channel < 3; ++channel)
+			normalise(_row.data() + channel * outputWidth, out + channel * plane, outputWidth, scale, rangeMin);
+	}
+	return true;
+}
+} // namespace peopleDetector
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace peopleDetector
+{
+
+/**< Pixel layouts a CPU frame source can hand out */
+enum class PixelFormat {
+	RGB8, // Interleaved 8-bit RGB
+	I420  // 8-bit planar Y, then U and V at half resolution (Y4M "420")
+};
+
+/**< Bytes of one width x height frame in format */
+size_t pixelFormatSize(PixelFormat format, uint32_t width, uint32_t height);
+
+/**
+ * CPU counterpart of jetson-inference's cudaTensorNormBGR(): nearest-neighbour
+ * resize to the network input, planar BGR output and a linear map of 0-255
+ * to [rangeMin, rangeMax], sampling the same source pixels as the CUDA kernel
+ * so both produce the same tensor. Each output row is gathered into byte
+ * planes first, then converted with NEON or SSE2. Tables and scratch are
+ * kept between calls, so steady-state calls do not allocate.
+ */
+class CpuTensorNorm
+{
+      public:
+	bool normBGR(const void* input, PixelFormat format, uint32_t width, uint32_t height, float* output, uint32_t outputWidth,
+		     uint32_t outputHeight, float rangeMin = -1.0f, float rangeMax = 1.0f);
+
+      private:
+	void resize(uint32_t width, uint32_t height, uint32_t outputWidth, uint32_t outputHeight);
+	void gatherRGB8(const uint8_t* rgb, uint32_t width, uint32_t y);
+	void gatherI420(const uint8_t* yuv, uint32_t width, uint32_t height, uint32_t y);
+
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	uint32_t _outputWidth = 0;
+	uint32_t _outputHeight = 0;
+	std::vector<uint32_t> _sourceX; // Source column of each output column
+	std::vector<uint32_t> _sourceY; // Source row of each output row
+	std::vector<uint8_t> _row;	// B, G and R planes of one output row
+};
+} // namespace peopleDetector
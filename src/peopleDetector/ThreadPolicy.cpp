@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <logging.h>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Config.hpp"
+#include "ThreadPolicy.hpp"
+namespace peopleDetector
+{
+
+namespace
+{
+struct ThreadEntry {
+	pid_t tid;
+	ThreadRole role;
+};
+
+std::mutex registryMutex;
+std::vector<ThreadEntry> registry;
+
+// Affinity of the process at startup, restored for roles without a CPU list
+const cpu_set_t startupCpus = [] {
+	cpu_set_t cpus;
+	if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0)
+		CPU_ZERO(&cpus);
+	return cpus;
+}();
+} // namespace
+
+static pid_t currentTid() { return syscall(SYS_gettid); }
+
+const char* threadRoleName(ThreadRole role)
+{
+	switch (role) {
+	case ThreadRole::CAPTURE:
+		return "capture";
+	case ThreadRole::DETECT:
+		return "detect";
+	case ThreadRole::TRACK:
+		return "track";
+	case ThreadRole::OUTPUT:
+		return "output";
+	default:
+		return "unknown";
+	}
+}
+
+// "0-2,5" -> CPUs 0, 1, 2 and 5
+static bool parseCpuList(const std::string& list, cpu_set_t& cpus)
+{
+	CPU_ZERO(&cpus);
+	const char* p = list.c_str();
+	while (*p) {
+		char* end;
+		const long first = strtol(p, &end, 10);
+		if (end == p)
+			return false;
+		long last = first;
+		p = end;
+		if (*p == '-') {
+			last = strtol(p + 1, &end, 10);
+			if (end == p + 1)
+				return false;
+			p = end;
+		}
+		if (first < 0 || last < first || last >= CPU_SETSIZE)
+			return false;
+		for (long cpu = first; cpu <= last; ++cpu)
+			CPU_SET(cpu, &cpus);
+		if (*p == ',')
+			++p;
+		else if (*p)
+			return false;
+	}
+	return CPU_COUNT(&cpus) > 0;
+}
+
+bool isValidCpuList(const std::string& list)
+{
+	cpu_set_t cpus, available;
+	if (!parseCpuList(list, cpus))
+		return false;
+	CPU_AND(&available, &cpus, &startupCpus);
+	return CPU_EQUAL(&available, &cpus);
+}
+
+bool applyThreadRole(ThreadRole role, const char* name)
+{
+	const Config& config = currentConfig();
+	const std::string* cpuLists[] = {&config.captureCpus, &config.detectCpus, &config.trackCpus, &config.outputCpus};
+	const int priorities[] = {config.capturePriority, config.detectPriority, config.trackPriority, config.outputPriority};
+	const std::string& cpuList = *cpuLists[(int)role];
+	const int priority = priorities[(int)role];
+
+	if (name)
+		pthread_setname_np(pthread_self(), std::string(name).substr(0, 15).c_str());
+	else
+		name = threadRoleName(role);
+
+	// A thread can change roles (the frame loop creates the camera as
+	// CAPTURE first), so unset settings restore the startup defaults
+	bool ok = true;
+	cpu_set_t cpus = startupCpus;
+	if (!cpuList.empty() && !parseCpuList(cpuList, cpus)) {
+		LogError("ThreadPolicy -- invalid CPU list '%s' for %s\n", cpuList.c_str(), threadRoleName(role));
+		cpus = startupCpus;
+		ok = false;
+	}
+	if (CPU_COUNT(&cpus) > 0) {
+		if (int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+			LogError("ThreadPolicy -- cannot pin %s to CPUs %s: %s\n", name, cpuList.c_str(), strerror(err));
+			ok = false;
+		}
+	}
+
+	sched_param param = {};
+	const int policy = priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+	param.sched_priority = priority > 0 ? std::min(priority, sched_get_priority_max(SCHED_FIFO)) : 0;
+	if (priority > 0 || sched_getscheduler(0) != SCHED_OTHER) {
+		if (int err = pthread_setschedparam(pthread_self(), policy, &param)) {
+			LogError("ThreadPolicy -- cannot set %s %i for %s: %s\n", policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_OTHER",
+				 param.sched_priority, name, strerror(err));
+			ok = false;
+		}
+	}
+
+	const ThreadEntry entry = {currentTid(), role};
+	releaseThreadRole();
+	std::lock_guard<std::mutex> lock(registryMutex);
+	registry.push_back(entry);
+	return ok;
+}
+
+void releaseThreadRole()
+{
+	const pid_t tid = currentTid();
+	std::lock_guard<std::mutex> lock(registryMutex);
+	registry.erase(std::remove_if(registry.begin(), registry.end(), [tid](const ThreadEntry& e) { return e.tid == tid; }),
+		       registry.end());
+}
+
+// Fields of /proc/self/task/<tid>/status and stat used by the report
+struct ThreadStatus {
+	char cpusAllowed[64] = "?";
+	long voluntary = -1;
+	long involuntary = -1;
+	int processor = -1;
+	int policy = -1;
+	int rtPriority = 0;
+};
+
+static bool readThreadStatus(pid_t tid, ThreadStatus& status)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int)tid);
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return false; // Thread has exited
+	char line[256];
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "Cpus_allowed_list: %63s", status.cpusAllowed) == 1)
+			continue;
+		if (sscanf(line, "voluntary_ctxt_switches: %ld", &status.voluntary) == 1)
+			continue;
+		sscanf(line, "nonvoluntary_ctxt_switches: %ld", &status.involuntary);
+	}
+	fclose(file);
+
+	// stat: processor, rt_priority and policy are fields 39 to 41; the
+	// name in field 2 may contain spaces, so count from the closing ')'
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)tid);
+	file = fopen(path, "r");
+	if (!file)
+		return false;
+	char stat[1024];
+	const size_t n = fread(stat, 1, sizeof(stat) - 1, file);
+	fclose(file);
+	stat[n] = '\0';
+	const char* p = strrchr(stat, ')');
+	for (int field = 2; p && field < 39; ++field)
+		p = strchr(p + 1, ' ');
+	if (p)
+		sscanf(p, " %d %d %d", &status.processor, &status.rtPriority, &status.policy);
+	return true;
+}
+
+static void readThreadName(pid_t tid, char* name, size_t size)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/task/%d/comm", (int)tid);
+	snprintf(name, size, "?");
+	if (FILE* file = fopen(path, "r")) {
+		if (fgets(name, size, file))
+			name[strcspn(name, "\n")] = '\0';
+		fclose(file);
+	}
+}
+
+void reportThreads()
+{
+	std::vector<ThreadEntry> entries;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		entries = registry;
+	}
+
+	// Every thread of the process, so unregistered ones (GStreamer,
+	// CUDA, driver threads) show where they ended up as well
+	DIR* dir = opendir("/proc/self/task");
+	if (!dir)
+		return;
+	LogInfo("ThreadPolicy -- thread placement:\n");
+	while (dirent* task = readdir(dir)) {
+		const pid_t tid = atoi(task->d_name);
+		if (tid <= 0)
+			continue;
+		ThreadStatus status;
+		if (!readThreadStatus(tid, status))
+			continue;
+
+		const ThreadEntry* entry = nullptr;
+		for (const ThreadEntry& e : entries) {
+			if (e.tid == tid)
+				entry = &e;
+		}
+		char name[16];
+		readThreadName(tid, name, sizeof(name));
+		LogInfo("ThreadPolicy --   %-15s %-7s tid %6d cpus %-8s on %2d %-5s %2d  switches %ld voluntary, %ld involuntary\n", name,
+			entry ? threadRoleName(entry->role) : "-", (int)tid, status.cpusAllowed, status.processor,
+			status.policy == SCHED_FIFO ? "FIFO" : "OTHER", status.rtPriority, status.voluntary, status.involuntary);
+	}
+	closedir(dir);
+}
+} // namespace peopleDetector
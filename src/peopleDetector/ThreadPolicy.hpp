@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+
+namespace peopleDetector
+{
+
+// Pipeline stages a thread can belong to
+enum class ThreadRole : int {
+	CAPTURE = 0, // GStreamer threads, inherit the placement of the thread creating the camera
+	DETECT,	     // Frame loop driving capture and inference
+	TRACK,	     // Track threads and tracking pool workers
+	OUTPUT,	     // Event writer, metrics endpoint, config watcher
+	COUNT
+};
+
+const char* threadRoleName(ThreadRole role);
+
+/**
+ * Pins the calling thread to the CPUs configured for role and, if the role
+ * has a priority (1-99), switches it to SCHED_FIFO. The placement comes
+ * from the current Config when the thread starts; running threads are not
+ * moved by a reload. Failures (e.g. no CAP_SYS_NICE) are logged and the
+ * thread keeps running with the default policy. The thread is named, unless
+ * name is null (the main thread's name is the process name), and registered
+ * for reportThreads(). Returns false if anything was not applied.
+ */
+bool applyThreadRole(ThreadRole role, const char* name);
+
+/**< Whether list is a CPU list like "0-1,3" of CPUs this process may run on */
+bool isValidCpuList(const std::string& list);
+
+/**< Drop the calling thread from the report, for threads that exit */
+void releaseThreadRole();
+
+/**< Log CPU placement, policy and context switches of every registered live thread */
+void reportThreads();
+
+/**< applyThreadRole() for the lifetime of a thread function */
+class ScopedThreadRole
+{
+      public:
+	ScopedThreadRole(ThreadRole role, const char* name) { applyThreadRole(role, name); }
+	~ScopedThreadRole() { releaseThreadRole(); }
+};
+} // namespace peopleDetector
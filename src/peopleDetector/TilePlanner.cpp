@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "TilePlanner.hpp"
+namespace peopleDetector
+{
+
+// Square tile of size centred on (x, y), shifted to lie inside the frame
+static Tile centredTile(float x, float y, int size, int width, int height)
+{
+	const int left = std::min(std::max((int)std::lround(x) - size / 2, 0), width - size);
+	const int top = std::min(std::max((int)std::lround(y) - size / 2, 0), height - size);
+	return {left, top, left + size, top + size};
+}
+
+bool TilePlanner::covered(const Tile* tiles, int numTiles, float x, float y) const
+{
+	// tiles[0] is the full frame and does not count as coverage
+	for (int i = 1; i < numTiles; ++i) {
+		if (tiles[i].contains(x, y, _trackMargin))
+			return true;
+	}
+	return false;
+}
+
+int TilePlanner::plan(int width, int height, float countingLineX, const float* points, int numPoints, Tile* tiles)
+{
+	int numTiles = 0;
+	tiles[numTiles++] = {0, 0, width, height};
+
+	const int budget = std::min(1 + _maxTiles, (int)maxPlannedTiles);
+	if (width <= _tileSize || height <= _tileSize)
+		return numTiles; // The full frame is already at crop resolution
+
+	// A column of crops along the counting line, evenly overlapping
+	const int gateTiles = std::min((height + _tileSize - 1) / _tileSize, budget - numTiles);
+	for (int i = 0; i < gateTiles; ++i) {
+		const float y = gateTiles > 1 ? _tileSize / 2 + i * (float)(height - _tileSize) / (gateTiles - 1) : height / 2.0f;
+		tiles[numTiles++] = centredTile(countingLineX, y, _tileSize, width, height);
+	}
+
+	// Then one crop per uncovered track, the ones about to cross first
+	_order.resize(numPoints);
+	std::iota(_order.begin(), _order.end(), 0);
+	std::sort(_order.begin(), _order.end(), [&](int a, int b) {
+		return std::fabs(points[2 * a] - countingLineX) < std::fabs(points[2 * b] - countingLineX);
+	});
+	for (int i = 0; i < numPoints && numTiles < budget; ++i) {
+		const float x = points[2 * _order[i]];
+		const float y = points[2 * _order[i] + 1];
+		if (x < 0 || y < 0 || x >= width || y >= height || covered(tiles, numTiles, x, y))
+			continue;
+		tiles[numTiles++] = centredTile(x, y, _tileSize, width, height);
+	}
+	return numTiles;
+}
+
+int TilePlanner::merge(Detection* detections, int n)
+{
+	_order.resize(n);
+	std::iota(_order.begin(), _order.end(), 0);
+	std::stable_sort(_order.begin(), _order.end(), [&](int a, int b) { return detections[a].Confidence > detections[b].Confidence; });
+	_suppressed.assign(n, 0);
+	_kept.clear();
+
+	for (int i = 0; i < n; ++i) {
+		if (_suppressed[_order[i]])
+			continue;
+		Detection kept = detections[_order[i]];
+		const float keptArea = kept.Area();
+
+		for (int j = i + 1; j < n; ++j) {
+			const Detection& other = detections[_order[j]];
+			if (_suppressed[_order[j]] || other.ClassID != kept.ClassID)
+				continue;
+			const float intersection = kept.IntersectionArea(other);
+			if (intersection <= 0)
+				continue;
+			const float otherArea = other.Area();
+			const float iou = intersection / (keptArea + otherArea - intersection);
+			const float containment = intersection / std::max(std::min(keptArea, otherArea), 1e-6f);
+			if (iou <= _nmsIou && containment <= _nmsContainment)
+				continue;
+
+			_suppressed[_order[j]] = 1;
+			if (otherArea > keptArea && intersection / std::max(keptArea, 1e-6f) > _nmsContainment)
+				kept.Expand(other);
+		}
+		_kept.push_back(kept);
+	}
+
+	for (size_t i = 0; i < _kept.size(); ++i) {
+		detections[i] = _kept[i];
+		detections[i].Instance = i;
+	}
+	return _kept.size();
+}
+} // namespace peopleDetector
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Detection.hpp"
+
+namespace peopleDetector
+{
+
+// Crop of the frame in pixels, right and bottom exclusive
+struct Tile {
+	int left, top, right, bottom;
+
+	inline int width() const { return right - left; }
+	inline int height() const { return bottom - top; }
+	inline bool contains(float x, float y, float margin) const
+	{
+		return x >= left + margin && x < right - margin && y >= top + margin && y < bottom - margin;
+	}
+};
+
+/**
+ * Picks the crops the detector runs on for one frame and merges their
+ * detections again. The full frame is always the first tile, for the near
+ * field; on top of it, square crops close to the network's input
+ * resolution cover the counting line and then the predicted positions of
+ * the live tracks (nearest to the line first) until the tile budget is
+ * spent, so small far-field people are seen at a usable scale. Pure CPU
+ * geometry, no network or GPU involved.
+ */
+class TilePlanner
+{
+      public:
+	// ################### Settings ###################
+	const int _tileSize = 360;	   // Square crops, ~1.2x the 300x300 network input
+	const int _maxTiles = 4;	   // Crops per frame besides the full frame
+	const float _trackMargin = 48.0f;  // Predicted positions are kept this far inside a crop
+	const float _nmsIou = 0.5f;	   // Same-class boxes overlapping more are duplicates
+	const float _nmsContainment = 0.7f; // ... as are boxes mostly inside another, e.g. cut by a crop edge
+	static const int maxPlannedTiles = 8;
+	// ################################################
+
+	/**
+	 * Plan the tiles of a width x height frame. points are the predicted
+	 * track centres as numPoints (x, y) pairs. tiles must hold
+	 * maxPlannedTiles entries; returns the number written, tiles[0] being
+	 * the full frame.
+	 */
+	int plan(int width, int height, float countingLineX, const float* points, int numPoints, Tile* tiles);
+
+	/**
+	 * Cross-tile non-maximum suppression on detections already mapped to
+	 * frame coordinates. The most confident box of a duplicate group is
+	 * kept and grown to the union with any larger duplicate it lies mostly
+	 * inside, which restores boxes cut at a crop edge. Compacts in place and
+	 * returns the number kept, ordered by confidence.
+	 */
+	int merge(Detection* detections, int n);
+
+      private:
+	bool covered(const Tile* tiles, int numTiles, float x, float y) const;
+
+	std::vector<int> _order; // Scratch, sized on first use
+	std::vector<uint8_t> _suppressed;
+	std::vector<Detection> _kept;
+};
+} // namespace peopleDetector
@@ -1,12 +1,17 @@
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <mutex>
 #include <thread>
 
+#include "Appearance.hpp"
+#include "ThreadPolicy.hpp"
 #include "TrackedObject.hpp"
 namespace peopleDetector
 {
-int TrackedObject::_idCount = 0;
+std::atomic<uint32_t> TrackedObject::_idCount{0};
+const std::shared_ptr<Detection> TrackedObject::elapsedFrame = std::make_shared<Detection>();
+static_assert(Config::maxGateLines < Counter::maxGates, "every gate line needs its own tally");
 
 // Initialize state transition matrix
 Eigen::Matrix<float, 6, 6> TrackedObject::_A = [] {
@@ -25,9 +30,10 @@ Eigen::Matrix<float, 2, 6> TrackedObject::_H = [] {
 template <typename T> T MessageQueue<T>::receive()
 {
 	std::unique_lock<std::mutex> uLock(_mutex);
-	_cond.wait(uLock, [this] { return !_queue.empty(); });
-	T msg = std::move(_queue.back());
-	_queue.pop_back();
+	_cond.wait(uLock, [this] { return _size > 0; });
+	T msg = std::move(_queue[_head]);
+	_head = (_head + 1) % _maxSize;
+	--_size;
 
 	return msg;
 }
@@ -35,25 +41,44 @@ template <typename T> T MessageQueue<T>::receive()
 template <typename T> void MessageQueue<T>::send(T&& msg)
 {
 	std::lock_guard<std::mutex> uLock(_mutex);
-	_queue.push_back(std::move(msg));
+	if (_size == _maxSize) {
+		_head = (_head + 1) % _maxSize;
+		--_size;
+	}
+	_queue[(_head + _size) % _maxSize] = std::move(msg);
+	++_size;
 	_cond.notify_one();
 }
 
 void TrackedObject::timeUpdate()
 {
+	// Pick up reloaded variances
+	setCovariances(currentConfig());
 
 	// Predict state transition
 	_X = _A * _X;
 
 	// Update Error covariance matrix
 	_P = _A * (_P * _A.transpose()) + _Q;
+
+	// Cache innovation covariance for gating and the next measurement update
+	_S = _H * _P * _H.transpose() + _R;
+	_SInv = _S.inverse();
+
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	_gate.x = _X(0);
+	_gate.y = _X(1);
+	_gate.i00 = _SInv(0, 0);
+	_gate.i01 = _SInv(0, 1);
+	_gate.i11 = _SInv(1, 1);
+	_gate.valid = true;
 }
 
 void TrackedObject::measurementUpdate()
 {
 
-	// Compute Kalman Gain
-	auto _K = _P * _H.transpose() * (_H * _P * _H.transpose() + _R).inverse();
+	// Compute Kalman Gain, _SInv was cached by the preceding timeUpdate()
+	auto _K = _P * _H.transpose() * _SInv;
 
 	// Fuse new measurement
 	_X = _X + _K * (_Z - _H * _X);
@@ -64,99 +89,252 @@ void TrackedObject::measurementUpdate()
 
 void TrackedObject::sendDetection(std::shared_ptr<Detection> det) { _detectionQueue.send(std::move(det)); }
 
-TrackedObject::TrackedObject(std::shared_ptr<Detection> newDet, Counter* counter) : _id(_idCount), _counter(counter)
+TrackedObject::TrackedObject(std::shared_ptr<Detection> newDet, Counter* counter)
+    : _id(_idCount.fetch_add(1, std::memory_order_relaxed) & 0x7FFFFFFF), _classId(newDet->ClassID), _counter(counter)
 {
-	++_idCount;
+	_appearance = newDet->appearance;
+	_hasAppearance = newDet->hasAppearance;
+	_frameId = newDet->frameId;
 
 	// Initialize state vector with inital position
 	_X << newDet->x_mid, newDet->y_mid, 0, 0, 0, 0;
 
 	// Initialize Error Covariance matrix
-	_P << _initalErrorCovariance, 0, 0, 0, 0, 0, 0, _initalErrorCovariance, 0, 0, 0, 0, 0, 0, _initalErrorCovariance, 0, 0, 0, 0, 0, 0,
-	    _initalErrorCovariance, 0, 0, 0, 0, 0, 0, _initalErrorCovariance, 0, 0, 0, 0, 0, 0, _initalErrorCovariance;
+	const Config& config = currentConfig();
+	_P = Eigen::Matrix<float, 6, 6>::Identity() * config.initialErrorCovariance;
+
+	setCovariances(config);
+	publishState();
+}
+
+TrackedObject::TrackedObject(const TrackState& state, Counter* counter)
+    : _id(state.id), _classId(state.classId), _counter(counter)
+{
+	_objectState = (ObjectState)state.objectState;
+	_firstState = (DetectionState)state.firstState;
+	_coastedFrames = state.coastedFrames;
+	_appearance = state.appearance;
+	_hasAppearance = state.hasAppearance;
+	_X = Eigen::Map<const Eigen::Matrix<float, 6, 1>>(state.X);
+	_P = Eigen::Map<const Eigen::Matrix<float, 6, 6>>(state.P);
+
+	setCovariances(currentConfig());
+	publishState();
+
+	// Predict the first frame after the restart
+	if (_objectState != init && _objectState != terminated)
+		timeUpdate();
+}
 
-	// Initialize Measurement Covariance matrix
-	_R << _measurmantVariance, 0, 0, _measurmantVariance;
+void TrackedObject::setCovariances(const Config& config)
+{
+	// Keyed on the values, not the snapshot address: a replaced snapshot is
+	// freed after the grace period and a later one may reuse its address
+	if (config.measurementVariance == _measurementVariance && config.processVariance == _processVariance)
+		return;
+	_measurementVariance = config.measurementVariance;
+	_processVariance = config.processVariance;
+
+	// Measurement Covariance matrix
+	_R = Eigen::Matrix<float, 2, 2>::Identity() * config.measurementVariance;
+
+	// Process Covariance matrix
+	_Q = Eigen::Matrix<float, 6, 6>::Identity() * config.processVariance;
+}
 
-	// Initialize Process Covariance matrix
-	_Q << _processVariance, 0, 0, 0, 0, 0, 0, _processVariance, 0, 0, 0, 0, 0, 0, _processVariance, 0, 0, 0, 0, 0, 0, _processVariance, 0, 0, 0,
-	    0, 0, 0, _processVariance, 0, 0, 0, 0, 0, 0, _processVariance;
+void TrackedObject::publishState()
+{
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	_state.id = _id;
+	_state.objectState = _objectState;
+	_state.firstState = (int32_t)_firstState;
+	_state.coastedFrames = _coastedFrames;
+	_state.classId = _classId;
+	Eigen::Map<Eigen::Matrix<float, 6, 1>>(_state.X) = _X;
+	Eigen::Map<Eigen::Matrix<float, 6, 6>>(_state.P) = _P;
+	_state.appearance = _appearance;
+	_state.hasAppearance = _hasAppearance;
+}
+
+TrackState TrackedObject::getState()
+{
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	return _state;
 }
 
 void TrackedObject::run()
 {
-	while (_objectState != terminated) {
+	ScopedThreadRole role(ThreadRole::TRACK, "track");
+	while (_objectState != terminated)
+		step(_detectionQueue.receive());
+}
+
+void TrackedObject::step(std::shared_ptr<Detection> newDetection)
+{
+	const Config& config = currentConfig();
+
+	if (newDetection == elapsedFrame) {
+		// An init track waits for its second detection on the next
+		// inferred frame, the others coast on their prediction
+		if (_objectState == init)
+			return;
+		newDetection = nullptr;
+	}
 
-		// Run predict step of Kalman filter
-		if (_objectState != init) {
-			timeUpdate();
+	if (newDetection == nullptr) {
+		// If there is no new detection associated while the
+		// track is still in init phase, terminate it
+		if (_objectState == init) {
+			_objectState = terminated;
+		} else {
+			_objectState = coast;
+			++_coastedFrames;
+			if (_frameId >= 0)
+				++_frameId;
 		}
 
-		auto newDetection = _detectionQueue.receive();
+	} else {
+		// if this is the first associated detection when the
+		// tract is still in the init phase, initalize the
+		// velocity eimste
+		if (_objectState == init) {
+			float vxEstimate = newDetection->x_mid - _X(0);
+			float vyEstimate = newDetection->y_mid - _X(1);
 
-		if (newDetection == nullptr) {
-			// If there is no new detection associated while the
-			// track is still in init phase, terminate it
-			if (_objectState == init) {
-				_objectState = terminated;
-			} else {
-				_objectState = coast;
-				++_coastedFrames;
-			}
+			_X(2) = vxEstimate;
+			_X(3) = vyEstimate;
 
-		} else {
-			// if this is the first associated detection when the
-			// tract is still in the init phase, initalize the
-			// velocity eimste
-			if (_objectState == init) {
-				float vxEstimate = newDetection->x_mid - _X(0);
-				float vyEstimate = newDetection->y_mid - _X(1);
-
-				_X(2) = vxEstimate;
-				_X(3) = vyEstimate;
-
-				// Run first time update to catch up
-				timeUpdate();
-				if (newDetection->x_mid < 400) {
-					_firstState = DetectionState::INCOMER;
-
-				} else {
-					_firstState = DetectionState::EXITER;
-				}
+			// Run first time update to catch up
+			timeUpdate();
+			if (newDetection->x_mid < config.incomerLineX) {
+				_firstState = DetectionState::INCOMER;
+
+			} else {
+				_firstState = DetectionState::EXITER;
 			}
+		}
 
-			_objectState = active;
-			newDetection->trackId = _id;
+		_objectState = active;
 
-			updateCounter(newDetection);
-			_coastedFrames = 0;
+		updateCounter(newDetection);
+		_coastedFrames = 0;
+		_frameId = newDetection->frameId;
 
-			// Load new measurment into z
-			_Z << newDetection->x_mid, newDetection->y_mid;
+		// Load new measurment into z
+		_Z << newDetection->x_mid, newDetection->y_mid;
 
-			measurementUpdate();
-		}
+		measurementUpdate();
+	}
 
-		// Prune if track has been coasting too long
-		if (_coastedFrames > _maxCoastCount) {
-			_objectState = terminated;
-		}
+	// Prune if track has been coasting too long
+	if (_coastedFrames > config.maxCoastCount) {
+		_objectState = terminated;
 	}
+	if (_objectState == active || _objectState == coast)
+		recordPosition();
+	publishState();
+
+	// Run predict step of Kalman filter, the gate is then ready for
+	// the association of the next frame
+	if (_objectState != terminated)
+		timeUpdate();
+}
+
+void TrackedObject::recordPosition()
+{
+	if (_heatmap)
+		_heatmap->add(_X(0), _X(1));
+
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	_trajectory.push(_X(0), _X(1), _frameId);
+}
+
+int TrackedObject::getTrajectory(TrajectoryPoint* out, int maxPoints)
+{
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	return _trajectory.copyTo(out, maxPoints);
 }
 void TrackedObject::updateCounter(std::shared_ptr<Detection> newDetection)
-{ // fix hardcode width picture
-	if (newDetection->x_mid > 640 && _firstState == DetectionState::INCOMER) {
-		_counter->decrement();
+{
+	const Config& config = currentConfig();
+	const float countingLineX = config.countingLineX;
+	if (newDetection->x_mid > countingLineX && _firstState == DetectionState::INCOMER) {
+		_counter->decrement(0, _classId);
 		_firstState = DetectionState::EXITER;
+		emitCrossing(0, CrossingDirection::OUT, newDetection->Confidence);
 	}
-	if (newDetection->x_mid < 640 && _firstState == DetectionState::EXITER) {
-		_counter->increment();
+	if (newDetection->x_mid < countingLineX && _firstState == DetectionState::EXITER) {
+		_counter->increment(0, _classId);
 		_firstState = DetectionState::INCOMER;
+		emitCrossing(0, CrossingDirection::IN, newDetection->Confidence);
+	}
+
+	// Further gates, leftwards is in as on gate 0. The first detection
+	// only records the side.
+	for (int g = 0; g < config.numGateLines; ++g) {
+		const int8_t side = newDetection->x_mid < config.gateLineX[g] ? -1 : 1;
+		if (_gateSide[g] > 0 && side < 0) {
+			_counter->enterGate(g + 1);
+			emitCrossing(g + 1, CrossingDirection::IN, newDetection->Confidence);
+		} else if (_gateSide[g] < 0 && side > 0) {
+			_counter->leaveGate(g + 1);
+			emitCrossing(g + 1, CrossingDirection::OUT, newDetection->Confidence);
+		}
+		_gateSide[g] = side;
 	}
 }
 
+void TrackedObject::emitCrossing(int gate, CrossingDirection direction, float confidence)
+{
+	if (!_events)
+		return;
+
+	CrossingEvent event;
+	event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	event.trackId = _id;
+	event.gate = gate;
+	event.classId = _classId;
+	event.direction = direction;
+	event.confidence = confidence;
+	_events->push(event);
+}
+
 float TrackedObject::measureDistance(std::shared_ptr<Detection> det)
 {
 	return std::sqrt(std::pow((det->x_mid - _X(0)), 2) + std::pow((det->y_mid - _X(1)), 2));
 }
+
+TrackGate TrackedObject::getGate()
+{
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	TrackGate gate = _gate;
+	if (!gate.valid) {
+		// No prediction yet, position is the initial detection
+		gate.x = _X(0);
+		gate.y = _X(1);
+	}
+	return gate;
+}
+
+float TrackedObject::measureAppearance(const Detection& det)
+{
+	// Without signatures on both sides appearance is neutral
+	if (!_hasAppearance || !det.hasAppearance)
+		return 1.0f;
+	return appearanceSimilarity(_appearance, det.appearance);
+}
+
+void TrackedObject::updateAppearance(const Detection& det)
+{
+	if (!det.hasAppearance)
+		return;
+	// publishState() copies the signature on the track thread
+	std::lock_guard<std::mutex> lock(_gateMutex);
+	if (_hasAppearance) {
+		blendAppearance(_appearance, det.appearance);
+	} else {
+		_appearance = det.appearance;
+		_hasAppearance = true;
+	}
+}
 } // namespace peopleDetector
\ No newline at end of file
@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
-#include <deque>
 #include <iostream>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "Config.hpp"
 #include "Counter.hpp"
+#include "CrossingEvent.hpp"
 #include "Detection.hpp"
+#include "Heatmap.hpp"
+#include "Trajectory.hpp"
 
 #ifdef Success // Eigen fail without this
 #undef Success
@@ -23,53 +27,106 @@ enum class DetectionState : int { UNINITIALIZED = 0, EXITER = 1, INCOMER = 2 };
 
 enum ObjectState { init, active, coast, terminated };
 
+// Association gate of a track for the current frame
+struct TrackGate {
+	float x, y;	     // Predicted position
+	float i00, i01, i11; // Inverse innovation covariance (symmetric 2x2)
+	bool valid = false;  // False until the first prediction has run
+};
+
+// Plain copy of a track's filter state, as kept in checkpoints
+struct TrackState {
+	int32_t id;
+	int32_t objectState;
+	int32_t firstState;
+	int32_t coastedFrames;
+	uint32_t classId;
+	float X[6];  // State estimate
+	float P[36]; // Error covariance, column-major
+	Appearance appearance;
+	uint8_t hasAppearance;
+};
+
+// FIFO in a fixed ring: once _maxSize messages are waiting the oldest is
+// dropped, so a track thread that falls behind cannot grow its queue without
+// limit, and sending never allocates
 template <class T> class MessageQueue
 {
       public:
+	// ################### Settings ###################
+	static const size_t _maxSize = 8;
+	// ################################################
+
 	T receive();
 	void send(T&& msg);
 
       private:
 	std::mutex _mutex;
 	std::condition_variable _cond;
-	std::deque<T> _queue;
+	T _queue[_maxSize];
+	size_t _head = 0; // Oldest waiting message
+	size_t _size = 0;
 };
 
 class TrackedObject
 {
       public:
-	const int _id; // Unique constant id for the object
+	const int _id;		  // Unique constant id for the object
+	const uint32_t _classId; // Class of the first detection, tracks never change class
 
-	// ################### Settings ###################
-	const int _maxCoastCount = 20;
-	const float _initalErrorCovariance = 1.0;
-	const float _processVariance = 1.0;
-	const float _measurmantVariance = 1.0;
-	// ################################################
+	// Coasting limit, variances and counting lines come from the live
+	// Config snapshot (Config.hpp), read once per filter step
 
 	TrackedObject(std::shared_ptr<Detection>);
 	TrackedObject(std::shared_ptr<Detection>, Counter* counter);
+	TrackedObject(const TrackState& state, Counter* counter); // Resume a checkpointed track
 
 	void run();			       // Main run loop to be activated in thread started by manager
+	void step(std::shared_ptr<Detection>); // One filter step, nullptr for a missed frame; run() calls it per message
+
+	// Message of a frame without inference (shed load, motion gate):
+	// nothing could be missed, so it only advances the prediction
+	static const std::shared_ptr<Detection> elapsedFrame;
 	std::vector<float> getStateEstimate(); // Getter function returns {x, y,
 					       // v_x, v_y} for track.
-	ObjectState getObjectState() { return _objectState; }
+	ObjectState getObjectState() { return _objectState.load(std::memory_order_acquire); }
 	float measureDistance(std::shared_ptr<Detection>);
+	TrackGate getGate(); // Snapshot of the gate cached by the last prediction
+	TrackState getState(); // Snapshot of the filter state after the last step
+	float measureAppearance(const Detection&); // Similarity in [0, 1] to the track's signature
+	void updateAppearance(const Detection&);  // Blend the detection into the running signature, tracker thread only
 	void sendDetection(std::shared_ptr<Detection>);
 	inline void setCounter(Counter& counter) { _counter = &counter; };
+	inline void setEventRing(CrossingEventRing* events) { _events = events; };
+	inline void setHeatmap(Heatmap* heatmap) { _heatmap = heatmap; };
+	int getTrajectory(TrajectoryPoint* out, int maxPoints); // Recent positions, oldest first
 	void updateCounter(std::shared_ptr<Detection> newDetection);
 
+	// Track id allocator, saved and restored with the checkpoint
+	static inline uint32_t getNextId() { return _idCount.load(std::memory_order_relaxed); }
+	static inline void setNextId(uint32_t id) { _idCount.store(id, std::memory_order_relaxed); }
+
       private:
-	static int _idCount; // Static member increments in constructor and
-			     // ensures unique _id for each object
+	static std::atomic<uint32_t> _idCount; // Static member increments in constructor and
+					       // ensures unique _id for each object,
+					       // wraps to 0 after INT_MAX
 	MessageQueue<std::shared_ptr<Detection>> _detectionQueue;
 	Counter* _counter;
+	CrossingEventRing* _events = nullptr; // Optional crossing event output
+	Heatmap* _heatmap = nullptr;	       // Optional occupancy grid
 	DetectionState _firstState{DetectionState::UNINITIALIZED};
+	int8_t _gateSide[Config::maxGateLines] = {}; // Side of each further gate line, -1 left, 1 right, 0 not seen yet
 	static Eigen::Matrix<float, 6, 6> _A; // State transition matrix (static)
 	static Eigen::Matrix<float, 2, 6> _H; // Measurement matrix (static)
 
-	ObjectState _objectState = init;
+	std::atomic<ObjectState> _objectState{init}; // Written by the track thread, polled by the tracker
 	int _coastedFrames = 0;
+	int _frameId = -1; // Frame of the last step, -1 until a detection was seen
+
+	// Running average of the associated detections' colour histograms.
+	// Written by the tracker thread under _gateMutex, read there without it
+	Appearance _appearance;
+	bool _hasAppearance = false;
 
 	// State estimate vector
 	Eigen::Matrix<float, 6, 1> _X;
@@ -83,10 +140,27 @@ class TrackedObject
 	// Process covariance matrix
 	Eigen::Matrix<float, 6, 6> _Q;
 
+	// Variances _R and _Q were built from, rebuilt only when a reload changes them
+	float _measurementVariance = -1.0f;
+	float _processVariance = -1.0f;
+
 	// Measurement vector
 	Eigen::Matrix<float, 2, 1> _Z;
 
+	// Innovation covariance H P H^T + R of the last prediction and its inverse
+	Eigen::Matrix<float, 2, 2> _S;
+	Eigen::Matrix<float, 2, 2> _SInv;
+
+	std::mutex _gateMutex; // Guards _gate, _state and _trajectory, read by the tracker thread, and writes of _appearance
+	TrackGate _gate;
+	TrackState _state;
+	Trajectory _trajectory;
+
 	void timeUpdate();
 	void measurementUpdate();
+	void setCovariances(const Config& config);
+	void publishState();
+	void recordPosition();
+	void emitCrossing(int gate, CrossingDirection direction, float confidence);
 };
 } // namespace peopleDetector
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "Tracker.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <logging.h>
 #include <mutex>
@@ -8,21 +10,33 @@ namespace peopleDetector
 {
 Tracker::Tracker() : _counter(nullptr) {}
 
-Tracker::Tracker(Counter& counter) : _counter(&counter) {}
+Tracker::Tracker(Counter& counter, bool synchronous) : _synchronous(synchronous), _counter(&counter) {}
 
-void Tracker::setNewDetections(int idx, DetectionVec incomingDetections)
+Tracker::~Tracker()
+{
+	// Live tracks block in receive() until they are fed; the threads own a
+	// reference to their track, so they can be left to the process exit
+	for (auto& thread : _threads) {
+		if (thread.joinable())
+			thread.detach();
+	}
+}
+
+void Tracker::setNewDetections(int idx, const DetectionVec& incomingDetections)
 {
 	cout_mtx_.lock();
 	LogVerbose("//Tracker// Running setNewDetections()\n");
 	cout_mtx_.unlock();
 
 	_newDetections.clear();
-	for (auto& det : incomingDetections) {
+	_batch.clear();
+	for (const auto& det : incomingDetections) {
 		det->frameId = idx;
-		det->x_mid = ((float)(det->Left) + (float)(det->Right)) / 2;
-		det->y_mid = ((float)(det->Top) + (float)(det->Bottom)) / 2;
+		const int i = _batch.push(*det);
+		det->x_mid = _batch.xMid(i);
+		det->y_mid = _batch.yMid(i);
 	}
-	_newDetections = std::move(incomingDetections);
+	_newDetections = incomingDetections; // Reuses the capacity of earlier frames
 }
 
 void Tracker::associate()
@@ -32,68 +46,352 @@ void Tracker::associate()
 
 	cout_mtx_.unlock();
 
+	pruneTracks();
+
+	// One snapshot for the whole frame so every track sees the same values
+	const Config& config = currentConfig();
+	_appearanceWeight = config.appearanceWeight;
+	buildGatingGraph(config);
+
+	// Tracks compete only with tracks they share a candidate detection
+	// with, so connected components of the gating graph can be solved
+	// independently; each is solved greedily in track order, which gives
+	// exactly the assignment of one pass over all tracks.
+	const int numLive = _liveTracks.size();
+	if (!onPool(numLive)) {
+		_order.resize(numLive);
+		for (int i = 0; i < numLive; ++i)
+			_order[i] = i;
+		solveTracks(0, numLive);
+	} else {
+		splitComponents();
+		const int numChunks = _chunkBegin.size() - 1;
+		for (int c = 1; c < numChunks; ++c)
+			_associationPool->submit([this, c]() { solveTracks(_chunkBegin[c], _chunkBegin[c + 1]); });
+		solveTracks(_chunkBegin[0], _chunkBegin[1]);
+		_associationPool->wait();
+	}
+
+	// Apply in track order, so feeding, counting and events happen in the
+	// same sequence however the solve was split
+	for (int i = 0; i < numLive; ++i) {
+		auto& track = _tracks[_liveTracks[i]];
+		const int best_det = _assignment[i];
+
+		if (best_det >= 0) {
+			auto& det = _newDetections[best_det];
+			det->associated = true;
+			det->trackId = track->_id;
+			track->updateAppearance(*det);
+			feed(*track, det);
+			LogVerbose("//Tracker// Detection %i associated to Track %i (cost %f)\n", best_det, track->_id, _assignmentCost[i]);
+		} else {
+			LogVerbose("//Tracker// Track %i NOT associated! Sending nullptr...\n", track->_id);
+			feed(*track, nullptr);
+		}
+	}
+}
+
+void Tracker::elapse(int idx)
+{
+	LogVerbose("//Tracker// Frame %i without inference, predicting only\n", idx);
+
+	// Unassociated detections of the last frame must not start tracks now
+	_newDetections.clear();
+	_batch.clear();
+
+	pruneTracks();
+	for (auto& track : _tracks)
+		feed(*track, TrackedObject::elapsedFrame);
+}
+
+void Tracker::buildGatingGraph(const Config& config)
+{
+	_distanceThreshold = config.associationDistanceThreshold;
+	_gateChiSquare = config.gateChiSquare;
+
+	_liveTracks.clear();
 	for (int i_track = 0; i_track < _tracks.size(); ++i_track) {
-		auto& track = _tracks[i_track];
+		if (_tracks[i_track]->getObjectState() != terminated)
+			_liveTracks.push_back(i_track);
+	}
+	const int numLive = _liveTracks.size();
+	_edgeBegin.resize(numLive + 1);
+	_edges.clear();
 
-		if (track->getObjectState() != terminated) {
-			cout_mtx_.lock();
-			LogVerbose("//Tracker// !!!Track!!!: %i\n", track->_id);
+	// Crowded frames gate contiguous ranges of tracks on the pool, each
+	// into an edge list of its own, appended in track order afterwards
+	_gatingChunks = onPool(numLive) ? std::min(_associationPool->getThreadCount() + 1, numLive) : 1;
+	if ((int)_gatingScratch.size() < _gatingChunks)
+		_gatingScratch.resize(_gatingChunks);
+	for (int c = 1; c < _gatingChunks; ++c)
+		_associationPool->submit([this, c]() { gateTracks(c); });
+	gateTracks(0);
+	if (_gatingChunks > 1) {
+		_associationPool->wait();
+		for (int c = 1; c < _gatingChunks; ++c) {
+			const uint32_t offset = _edges.size();
+			for (int i = c * numLive / _gatingChunks; i < (c + 1) * numLive / _gatingChunks; ++i)
+				_edgeBegin[i] += offset;
+			const auto& edges = _gatingScratch[c].edges;
+			_edges.insert(_edges.end(), edges.begin(), edges.end());
+		}
+	}
+	_edgeBegin[numLive] = _edges.size();
 
-			cout_mtx_.unlock();
+	_assignment.assign(numLive, -1);
+	_assignmentCost.assign(numLive, 0.0f);
+	_taken.assign(_newDetections.size(), 0);
+}
 
-			bool track_associated = false;
+void Tracker::gateTracks(int chunk)
+{
+	GatingScratch& scratch = _gatingScratch[chunk];
+	std::vector<Edge>& edges = chunk == 0 ? _edges : scratch.edges;
+	edges.clear();
+	scratch.distances.resize(_batch.size());
+	scratch.gateDistances.resize(_batch.size());
 
-			for (int i_det = 0; i_det < _newDetections.size(); ++i_det) {
-				auto& det = _newDetections[i_det];
-				cout_mtx_.lock();
-				LogVerbose("//Tracker// !!!Detection!!!: %f, %f\n", det->x_mid, det->y_mid);
+	const int numLive = _liveTracks.size();
+	for (int i = chunk * numLive / _gatingChunks; i < (chunk + 1) * numLive / _gatingChunks; ++i) {
+		auto& track = _tracks[_liveTracks[i]];
+		_edgeBegin[i] = edges.size(); // Relative to this chunk's edges
 
-				cout_mtx_.unlock();
+		// Candidates are detections of the track's class within the
+		// distance cap and, once the track has a prediction, inside the
+		// chi-square bound of its innovation covariance. The motion part
+		// of the cost is normalised distance.
+		const TrackGate gate = track->getGate();
+		_batch.centreDistances(gate.x, gate.y, scratch.distances.data());
+		if (gate.valid)
+			_batch.mahalanobis(gate.x, gate.y, gate.i00, gate.i01, gate.i11, scratch.gateDistances.data());
 
-				float distance = track->measureDistance(det);
-				cout_mtx_.lock();
-				LogVerbose("//Tracker// Measured distance: %f\n", distance);
+		for (int i_det = 0; i_det < _newDetections.size(); ++i_det) {
+			if (_newDetections[i_det]->ClassID != track->_classId)
+				continue;
+			if (gate.valid && scratch.gateDistances[i_det] > _gateChiSquare)
+				continue;
+			const float distance = scratch.distances[i_det];
+			if (distance > _distanceThreshold)
+				continue;
 
-				cout_mtx_.unlock();
+			const float motion_cost =
+			    gate.valid ? std::sqrt(scratch.gateDistances[i_det] / _gateChiSquare) : distance / _distanceThreshold;
+			edges.push_back({i_det, motion_cost});
+		}
+		LogVerbose("//Tracker// Track %i: %u candidates\n", track->_id, (unsigned)(edges.size() - _edgeBegin[i]));
+	}
+}
 
-				if (distance <= _assocationDistanceThreshold) {
-					det->associated = true;
-					track->sendDetection(det);
-					cout_mtx_.lock();
-					LogVerbose("//Tracker// Detection %i associated to Track %i\n", i_det, distance);
-					cout_mtx_.unlock();
-					det->trackId = track->_id;
-					track_associated = true;
-					break;
-				}
-			}
+// Union-find root with path halving
+static int findRoot(std::vector<int>& parent, int node)
+{
+	while (parent[node] != node) {
+		parent[node] = parent[parent[node]];
+		node = parent[node];
+	}
+	return node;
+}
 
-			if (!track_associated) {
-				cout_mtx_.lock();
+void Tracker::splitComponents()
+{
+	// Nodes are the live tracks, then the detections. The smaller root
+	// wins every union, so a component's root is its first track.
+	const int numLive = _liveTracks.size();
+	_parent.resize(numLive + _newDetections.size());
+	for (int i = 0; i < (int)_parent.size(); ++i)
+		_parent[i] = i;
+	for (int i = 0; i < numLive; ++i) {
+		for (uint32_t e = _edgeBegin[i]; e < _edgeBegin[i + 1]; ++e) {
+			const int a = findRoot(_parent, i);
+			const int b = findRoot(_parent, numLive + _edges[e].det);
+			if (a != b)
+				_parent[std::max(a, b)] = std::min(a, b);
+		}
+	}
+
+	// Counting sort of the tracks by component, stable so each component
+	// keeps track order, components ordered by their first track
+	_componentStart.assign(numLive + 1, 0);
+	for (int i = 0; i < numLive; ++i)
+		++_componentStart[findRoot(_parent, i) + 1];
+	for (int i = 0; i < numLive; ++i)
+		_componentStart[i + 1] += _componentStart[i];
+	_order.resize(numLive);
+	_fill.assign(_componentStart.begin(), _componentStart.end() - 1);
+	for (int i = 0; i < numLive; ++i)
+		_order[_fill[findRoot(_parent, i)]++] = i;
 
-				LogVerbose("//Tracker// Track NOT associated! Sendinng nullptr...\n");
+	// Cut the order into about one chunk per pool thread plus the caller,
+	// only between components
+	const int numChunks = std::min(_associationPool->getThreadCount() + 1, numLive);
+	const int target = (numLive + numChunks - 1) / numChunks;
+	_chunkBegin.assign(1, 0);
+	for (int k = 1; k < numLive; ++k) {
+		const bool componentStart = _order[k] == findRoot(_parent, _order[k]);
+		if (componentStart && k - _chunkBegin.back() >= target)
+			_chunkBegin.push_back(k);
+	}
+	_chunkBegin.push_back(numLive);
+}
 
-				cout_mtx_.unlock();
-				track->sendDetection(nullptr);
+void Tracker::solveTracks(int begin, int end)
+{
+	// Each track takes its cheapest candidate not taken by an earlier
+	// track; the cost blends motion and appearance
+	for (int k = begin; k < end; ++k) {
+		const int i = _order[k];
+		auto& track = _tracks[_liveTracks[i]];
+		int best_det = -1;
+		float best_cost = 0;
+		for (uint32_t e = _edgeBegin[i]; e < _edgeBegin[i + 1]; ++e) {
+			const int i_det = _edges[e].det;
+			if (_taken[i_det])
+				continue;
+			const float cost = (1 - _appearanceWeight) * _edges[e].motionCost +
+					   _appearanceWeight * (1 - track->measureAppearance(*_newDetections[i_det]));
+			if (best_det < 0 || cost < best_cost) {
+				best_det = i_det;
+				best_cost = cost;
 			}
 		}
+		if (best_det >= 0)
+			_taken[best_det] = 1;
+		_assignment[i] = best_det;
+		_assignmentCost[i] = best_cost;
 	}
 }
 
-void Tracker::createNewTracks()
+int Tracker::createNewTracks()
 {
 	cout_mtx_.lock();
 	//std::cout << "//Tracker// Running createNewTracks()." << std::endl;
 	LogVerbose("//Tracker// Running createNewTracks()\n");
 	cout_mtx_.unlock();
 
+	int started = 0;
 	for (auto& newDet : _newDetections) {
 		// For each remaining unassociated detection, start a new track
 		if (!newDet->associated) {
-			std::shared_ptr<TrackedObject> newTrack = std::make_shared<TrackedObject>(newDet, _counter);
-			_tracks.push_back(newTrack);
-			_threads.emplace_back(std::thread(&TrackedObject::run, newTrack));
+			++started;
+			start(std::make_shared<TrackedObject>(newDet, _counter));
+		}
+	}
+	return started;
+}
+
+int Tracker::getTrackStates(TrackState* states, int maxStates)
+{
+	int n = 0;
+	for (auto& track : _tracks) {
+		if (n >= maxStates)
+			break;
+		states[n] = track->getState();
+		if (states[n].objectState == active || states[n].objectState == coast)
+			++n;
+	}
+	return n;
+}
+
+void Tracker::restoreTracks(const TrackState* states, int numStates)
+{
+	for (int i = 0; i < numStates; ++i) {
+		start(std::make_shared<TrackedObject>(states[i], _counter));
+	}
+}
+
+void Tracker::start(std::shared_ptr<TrackedObject> track)
+{
+	track->setEventRing(_events);
+	track->setHeatmap(_heatmap);
+	_tracks.push_back(track);
+	if (_synchronous)
+		_threads.emplace_back(); // Keeps _threads parallel to _tracks
+	else
+		_threads.emplace_back(std::thread(&TrackedObject::run, track));
+}
+
+void Tracker::feed(TrackedObject& track, std::shared_ptr<Detection> det)
+{
+	if (_synchronous)
+		track.step(std::move(det));
+	else
+		track.sendDetection(std::move(det));
+}
+
+int Tracker::getTrajectory(int trackId, TrajectoryPoint* out, int maxPoints)
+{
+	for (auto& track : _tracks) {
+		if (track->_id == trackId)
+			return track->getTrajectory(out, maxPoints);
+	}
+	return 0;
+}
+
+int Tracker::getPredictions(float* xy, int maxPoints)
+{
+	int n = 0;
+	for (auto& track : _tracks) {
+		if (n >= maxPoints)
+			break;
+		if (track->getObjectState() == terminated)
+			continue;
+		const TrackGate gate = track->getGate();
+		if (!gate.valid)
+			continue;
+		xy[2 * n] = gate.x;
+		xy[2 * n + 1] = gate.y;
+		++n;
+	}
+	return n;
+}
+
+void Tracker::getZoneOccupancy(const Config& config, int* occupancy)
+{
+	for (int z = 0; z < config.numZones; ++z)
+		occupancy[z] = 0;
+	for (auto& track : _tracks) {
+		const ObjectState state = track->getObjectState();
+		if (state != active && state != coast)
+			continue;
+		const TrackGate gate = track->getGate();
+		for (int z = 0; z < config.numZones; ++z) {
+			const ZoneRect& zone = config.zone[z];
+			if (gate.x >= zone.left && gate.x < zone.right && gate.y >= zone.top && gate.y < zone.bottom)
+				++occupancy[z];
 		}
 	}
 }
+
+void Tracker::pruneTracks()
+{
+	// A terminated track has left its run loop and is never fed again, so
+	// its thread can be joined right away. Compact in place to keep the
+	// association order of the remaining tracks.
+	size_t kept = 0;
+	for (size_t i = 0; i < _tracks.size(); ++i) {
+		if (_tracks[i]->getObjectState() == terminated) {
+			if (_threads[i].joinable())
+				_threads[i].join();
+			continue;
+		}
+		if (kept != i) {
+			_tracks[kept] = std::move(_tracks[i]);
+			_threads[kept] = std::move(_threads[i]);
+		}
+		++kept;
+	}
+	_tracks.resize(kept);
+	_threads.resize(kept);
+}
+
+int Tracker::getLiveTrackCount(int classId)
+{
+	int live = 0;
+	for (auto& track : _tracks) {
+		if (track->getObjectState() != terminated && (classId < 0 || track->_classId == (uint32_t)classId))
+			++live;
+	}
+	return live;
+}
 } // namespace peopleDetector
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <condition_variable>
 #include <deque>
 #include <list>
 #include <mutex>
 #include <thread>
 
+#include "Config.hpp"
 #include "Counter.hpp"
+#include "DetectionBatch.hpp"
 #include "TrackedObject.hpp"
+#include "WorkStealingPool.hpp"
 extern std::mutex cout_mtx_;
 
 namespace peopleDetector
@@ -18,22 +22,90 @@ class Tracker
 	using DetectionVec = std::vector<std::shared_ptr<Detection>>;
 
 	Tracker();
-	Tracker(Counter& counter);
+	Tracker(Counter& counter, bool synchronous = false);
+	~Tracker();
 
 	bool _shutdown = false;
 
-	void setNewDetections(int, DetectionVec incomingDetections);
+	void setNewDetections(int, const DetectionVec& incomingDetections);
 	void associate();
-	void createNewTracks();
+	void elapse(int idx); // A frame without inference, instead of setNewDetections() and associate()
+	int createNewTracks(); // Returns the number of tracks started
+	inline void setEventRing(CrossingEventRing& events) { _events = &events; }
+	inline void setHeatmap(Heatmap& heatmap) { _heatmap = &heatmap; }
+	// Dense scenes: from minTracks live tracks on, gating and independent
+	// groups of tracks are spread over pool, with the same result as
+	// without it. The pool must not be busy with other work during
+	// associate().
+	static const int defaultParallelMinTracks = 32;
+	inline void setAssociationPool(WorkStealingPool* pool, int minTracks = defaultParallelMinTracks)
+	{
+		_associationPool = pool;
+		_parallelMinTracks = std::max(minTracks, 1); // No live tracks, nothing to split
+	}
+	int getLiveTrackCount(int classId = -1); // Tracks that are not terminated, optionally of one class
+	inline int getTrackCount() const { return _tracks.size(); } // Tracks (and threads) still held
+	int getTrackStates(TrackState* states, int maxStates); // Confirmed live tracks, for checkpoints
+	void restoreTracks(const TrackState* states, int numStates);
+	int getTrajectory(int trackId, TrajectoryPoint* out, int maxPoints); // 0 if the track is gone
+	int getPredictions(float* xy, int maxPoints); // Predicted centres of live tracks as (x, y) pairs, for TilePlanner
+	void getZoneOccupancy(const Config& config, int* occupancy); // Confirmed tracks inside each of config.zone
 
-	// ################### Settings ###################
-	const float _assocationDistanceThreshold = 100;
-	// ################################################
+	// Thresholds are read from the live Config snapshot (Config.hpp)
 
       private:
+	struct Edge {
+		int det;	  // Index into _newDetections
+		float motionCost; // Normalised distance part of the association cost
+	};
+
+	// Per gating task; task 0 (the tracker's thread) writes straight to _edges
+	struct GatingScratch {
+		std::vector<Edge> edges;
+		std::vector<float> distances;
+		std::vector<float> gateDistances;
+	};
+
+	inline bool onPool(int numLive) const { return _associationPool && numLive >= _parallelMinTracks; }
+	void buildGatingGraph(const Config& config);
+	void gateTracks(int chunk); // Live tracks [chunk, chunk + 1) * numLive / _gatingChunks
+	void splitComponents();
+	void solveTracks(int begin, int end); // Positions [begin, end) of _order
+	void pruneTracks();
+	void feed(TrackedObject& track, std::shared_ptr<Detection> det);
+	void start(std::shared_ptr<TrackedObject> track);
+
+	// Synchronous trackers step their tracks inline in associate() instead
+	// of on per-track threads, so results are deterministic and many
+	// trackers can share a thread pool (batch replays)
+	const bool _synchronous = false;
+
 	Counter* _counter;
+	CrossingEventRing* _events = nullptr;
+	Heatmap* _heatmap = nullptr;
 	std::vector<std::thread> _threads;		     // Threads for the TrackedObjects to run in
 	std::vector<std::shared_ptr<TrackedObject>> _tracks; // vector of shared_pts to tracks
 	DetectionVec _newDetections;			     // vector of shared_pts to detections
+	DetectionBatch _batch;				     // SoA geometry of _newDetections
+
+	// Association scratch, reused between frames
+	WorkStealingPool* _associationPool = nullptr;
+	int _parallelMinTracks = defaultParallelMinTracks; // Fewer live tracks are associated inline
+	float _appearanceWeight = 0;
+	float _distanceThreshold = 0;
+	float _gateChiSquare = 0;
+	int _gatingChunks = 1;
+	std::vector<GatingScratch> _gatingScratch;
+	std::vector<int> _liveTracks;	   // Indices into _tracks of the tracks being associated
+	std::vector<uint32_t> _edgeBegin;  // Candidates of live track i are _edges[_edgeBegin[i], _edgeBegin[i + 1])
+	std::vector<Edge> _edges;
+	std::vector<int> _parent;	   // Union-find over live tracks, then detections
+	std::vector<int> _componentStart;  // Counting sort offsets by component root
+	std::vector<int> _fill;
+	std::vector<int> _order;	   // Live tracks grouped by component, track order within each
+	std::vector<int> _chunkBegin;	   // Positions in _order where a pool task starts
+	std::vector<int> _assignment;	   // Detection of each live track, -1 if none
+	std::vector<float> _assignmentCost;
+	std::vector<uint8_t> _taken;	   // Per detection, written only by its component's task
 };
 } // namespace peopleDetector
\ No newline at end of file
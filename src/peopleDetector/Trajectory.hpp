@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace peopleDetector
+{
+
+static const int kTrajectoryLength = 64; // Positions kept per track, ~2 s at 30 FPS
+
+// Filtered position of a track after one step
+struct TrajectoryPoint {
+	float x, y;
+	int32_t frameId;
+};
+
+/**
+ * Fixed-capacity ring of a track's most recent positions. Storage is inline,
+ * so a track costs kTrajectoryLength * sizeof(TrajectoryPoint) no matter how
+ * long it lives, and push() never allocates. Not synchronised; the owner
+ * guards it.
+ */
+class Trajectory
+{
+      public:
+	inline void push(float x, float y, int32_t frameId)
+	{
+		_points[_next] = {x, y, frameId};
+		_next = (_next + 1) % kTrajectoryLength;
+		if (_size < kTrajectoryLength)
+			++_size;
+	}
+
+	inline int size() const { return _size; }
+
+	/**< Copy up to maxPoints of the newest points to out, oldest first, returns the number copied */
+	int copyTo(TrajectoryPoint* out, int maxPoints) const
+	{
+		const int n = maxPoints < _size ? maxPoints : _size;
+		int index = (_next - n + kTrajectoryLength) % kTrajectoryLength;
+		for (int i = 0; i < n; ++i) {
+			out[i] = _points[index];
+			index = (index + 1) % kTrajectoryLength;
+		}
+		return n;
+	}
+
+      private:
+	TrajectoryPoint _points[kTrajectoryLength];
+	int _next = 0;
+	int _size = 0;
+};
+} // namespace peopleDetector
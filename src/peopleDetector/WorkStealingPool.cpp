@@ -0,0 +1,140 @@
+#include <algorithm>
+
+#include "ThreadPolicy.hpp"
+#include "WorkStealingPool.hpp"
+namespace peopleDetector
+{
+
+// Pool and deque of the calling thread, if it is a worker
+static thread_local const WorkStealingPool* workerPool = nullptr;
+static thread_local int workerIndex = -1;
+
+WorkStealingPool::WorkStealingPool(int numThreads, ThreadRole role, const char* name) : _role(role), _name(name)
+{
+	if (numThreads <= 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 0; i < numThreads; ++i)
+		_queues.emplace_back(new Queue);
+	for (int i = 0; i < numThreads; ++i)
+		_threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (auto& thread : _threads)
+		thread.join();
+}
+
+void WorkStealingPool::submit(Task task) { push(std::move(task), false); }
+
+void WorkStealingPool::requeue(Task task) { push(std::move(task), true); }
+
+void WorkStealingPool::push(Task task, bool oldest)
+{
+	const int index = workerPool == this ? workerIndex : _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+	_pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+		if (oldest)
+			_queues[index]->tasks.push_front(std::move(task));
+		else
+			_queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		// Counted under _mutex so a worker about to sleep cannot miss it
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_queued;
+	}
+	_wake.notify_one();
+}
+
+uint64_t WorkStealingPool::getTasksRun() const
+{
+	uint64_t tasks = 0;
+	for (const auto& queue : _queues)
+		tasks += queue->tasksRun.load(std::memory_order_relaxed);
+	return tasks;
+}
+
+double WorkStealingPool::getUtilisation() const
+{
+	const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _startTime).count();
+	double busyNs = 0;
+	for (const auto& queue : _queues)
+		busyNs += queue->busyNs.load(std::memory_order_relaxed);
+	return elapsedNs > 0 ? busyNs / (elapsedNs * _queues.size()) : 0.0;
+}
+
+void WorkStealingPool::wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this] { return _pending.load() == 0; });
+}
+
+bool WorkStealingPool::take(int index, Task& task)
+{
+	// Own deque, newest first
+	{
+		Queue& own = *_queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// Steal the oldest task of the next non-empty deque
+	const int numQueues = _queues.size();
+	for (int i = 1; i < numQueues; ++i) {
+		Queue& victim = *_queues[(index + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			_steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::run(int index)
+{
+	ScopedThreadRole role(_role, _name);
+	workerPool = this;
+	workerIndex = index;
+
+	Task task;
+	for (;;) {
+		if (take(index, task)) {
+			--_queued;
+			const auto start = std::chrono::steady_clock::now();
+			task();
+			task = nullptr;
+			Queue& own = *_queues[index];
+			own.busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+					     std::memory_order_relaxed);
+			own.tasksRun.fetch_add(1, std::memory_order_relaxed);
+			if (_pending.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_idle.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_wake.wait(lock, [this] { return _queued.load() > 0 || _stop; });
+		if (_stop && _queued.load() == 0)
+			return;
+	}
+}
+} // namespace peopleDetector
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadPolicy.hpp"
+
+namespace peopleDetector
+{
+
+/**
+ * Fixed set of worker threads, each with its own task deque. A worker takes
+ * its newest task first and, once its deque is empty, steals the oldest task
+ * of another worker, so uneven tasks (a busy door next to a quiet one) keep
+ * every core loaded without a shared queue on the hot path. Idle workers
+ * sleep until something is submitted. Workers take the given ThreadPolicy
+ * role for their lifetime.
+ */
+class WorkStealingPool
+{
+      public:
+	using Task = std::function<void()>;
+
+	WorkStealingPool(int numThreads = 0, ThreadRole role = ThreadRole::TRACK, const char* name = "pool"); // 0 = one per hardware thread
+	~WorkStealingPool();
+
+	/**< Queue a task; from a worker it goes to that worker's deque, otherwise round-robin */
+	void submit(Task task);
+
+	/**< Like submit(), but behind everything already waiting: the oldest end of the deque, taken last by its worker */
+	void requeue(Task task);
+
+	/**< Block until every submitted task has finished */
+	void wait();
+
+	inline int getThreadCount() const { return _threads.size(); }
+	inline uint64_t getSteals() const { return _steals.load(std::memory_order_relaxed); }
+	uint64_t getTasksRun() const;
+
+	/**< Share of worker time spent in tasks since construction, in [0, 1] */
+	double getUtilisation() const;
+
+	/**< Task time of one worker in ns, shows how evenly stealing spread the load */
+	inline uint64_t getBusyNs(int worker) const { return _queues[worker]->busyNs.load(std::memory_order_relaxed); }
+
+      private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+
+		// Statistics of the worker owning this deque
+		std::atomic<uint64_t> busyNs{0};
+		std::atomic<uint64_t> tasksRun{0};
+	};
+
+	void run(int index);
+	void push(Task task, bool oldest);
+	bool take(int index, Task& task);
+
+	const ThreadRole _role;
+	const char* const _name;
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::vector<std::thread> _threads;
+	const std::chrono::steady_clock::time_point _startTime = std::chrono::steady_clock::now();
+
+	std::mutex _mutex; // Guards the sleep / wake-up of idle workers and wait()
+	std::condition_variable _wake;
+	std::condition_variable _idle;
+	std::atomic<int> _queued{0};  // Tasks sitting in a deque
+	std::atomic<int> _pending{0}; // Tasks submitted and not yet finished
+	std::atomic<unsigned> _nextQueue{0};
+	std::atomic<uint64_t> _steals{0};
+	bool _stop = false;
+};
+} // namespace peopleDetector
@@ -0,0 +1,186 @@
+// Steady-state allocation check of the CPU pipeline: synthetic 1280x720
+// frames of people walking back and forth across the counting line go
+// through CpuPeopleDetector, appearance, Tracker and Counter and the output
+// work that runs on the frame thread (detection log, checkpoint, archive,
+// shared-memory counts, zone occupancy, crossing events), with the heatmap
+// exported in the background. Built with PEOPLECOUNTER_ALLOC_TRACKING; after
+// warm-up every operator new outside the background threads fails the check,
+// except inside createNewTracks() on frames that start a track (the track
+// object and, with threads, its thread).
+//
+// Usage: PeopleCounterAllocs [frames] [--threads]
+//        --threads runs a track thread per track instead of stepping the
+//        tracks inline
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../peopleDetector/AllocTracker.hpp"
+#include "../peopleDetector/Appearance.hpp"
+#include "../peopleDetector/Checkpoint.hpp"
+#include "../peopleDetector/CountArchive.hpp"
+#include "../peopleDetector/CountPublisher.hpp"
+#include "../peopleDetector/Counter.hpp"
+#include "../peopleDetector/CpuPeopleDetector.hpp"
+#include "../peopleDetector/DetectionLog.hpp"
+#include "../peopleDetector/DetectionRing.hpp"
+#include "../peopleDetector/Heatmap.hpp"
+#include "../peopleDetector/Tracker.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::AllocTracker;
+using peopleDetector::Checkpoint;
+using peopleDetector::Config;
+using peopleDetector::CountArchive;
+using peopleDetector::CountPublisher;
+using peopleDetector::Counter;
+using peopleDetector::CpuPeopleDetector;
+using peopleDetector::CrossingEvent;
+using peopleDetector::CrossingEventRing;
+using peopleDetector::DetectionLease;
+using peopleDetector::DetectionLogWriter;
+using peopleDetector::DetectionRing;
+using peopleDetector::Heatmap;
+using peopleDetector::Tracker;
+
+// ################### Settings ###################
+const int frameWidth = 1280;
+const int frameHeight = 720;
+const int numPeople = 4;
+const int warmupFrames = 300;
+// ################################################
+
+// Person p walks back and forth between the frame edges on their own row
+static void renderFrame(std::vector<uint8_t>& frame, int idx)
+{
+	for (int y = 0; y < frameHeight; ++y) {
+		for (int x = 0; x < frameWidth; ++x) {
+			uint8_t* px = &frame[3 * (y * frameWidth + x)];
+			px[0] = 60 + (x / 40 % 4) * 10;
+			px[1] = 70 + (y / 30 % 3) * 10;
+			px[2] = 80;
+		}
+	}
+	for (int p = 0; p < numPeople; ++p) {
+		const float period = 2 * (frameWidth - 240);
+		const float phase = std::fmod(idx * (4.0f + p) + p * 300.0f, period);
+		const int left = 60 + (phase < period / 2 ? phase : period - phase);
+		const int top = 20 + p * 175;
+		for (int y = top; y < top + 150; ++y) {
+			for (int x = left; x < left + 60; ++x) {
+				uint8_t* px = &frame[3 * (y * frameWidth + x)];
+				px[0] = 230 - 40 * p;
+				px[1] = 60 + 40 * p;
+				px[2] = 200;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!AllocTracker::enabled()) {
+		printf("built without PEOPLECOUNTER_ALLOC_TRACKING, nothing to check\n");
+		return 2;
+	}
+	const int frames = argc > 1 ? atoi(argv[1]) : 3000;
+	const bool threads = argc > 2 && strcmp(argv[2], "--threads") == 0;
+
+	char dir[] = "/tmp/peoplecounter-allocs-XXXXXX";
+	if (!mkdtemp(dir))
+		return 1;
+	const std::string prefix = std::string(dir) + "/";
+
+	Config config;
+	config.zones = "0 0 640 720";
+	config.numZones = 1;
+	config.zone[0] = {0, 0, 640, 720};
+	peopleDetector::ScopedConfig scopedConfig(config);
+
+	static Counter counter(0);
+	static CrossingEventRing crossingEvents;
+	static Heatmap heatmap(frameWidth, frameHeight);
+	Tracker tracker(counter, !threads);
+	tracker.setEventRing(crossingEvents);
+	tracker.setHeatmap(heatmap);
+	heatmap.startExport(prefix + "heatmap.bin", 100);
+	CpuPeopleDetector detector;
+	DetectionLogWriter detectionLog;
+	detectionLog.open(prefix + "detections.detlog", frameWidth, frameHeight);
+	Checkpoint checkpoint(prefix + "checkpoint");
+	checkpoint.open();
+	CountArchive archive(prefix + "archive");
+	archive.open();
+	const std::string shmName = "/peoplecounter-allocs-" + std::to_string(getpid());
+	CountPublisher publisher(shmName);
+	publisher.open();
+
+	std::vector<uint8_t> frame(3 * frameWidth * frameHeight);
+	DetectionLease detections;
+	Tracker::DetectionVec frameDetections;
+	int zoneOccupancy[Config::maxZones];
+	CrossingEvent event;
+
+	uint64_t steadyAllocations = 0, births = 0;
+	int allocatingFrames = 0;
+	for (int idx = 0; idx < frames; ++idx) {
+		renderFrame(frame, idx);
+		const uint64_t frameStart = AllocTracker::getPipelineAllocations();
+		uint64_t exempt = 0;
+
+		frameDetections.clear();
+		const int numDetections = detector.Detect(frame.data(), frameWidth, frameHeight, detections);
+		for (int n = 0; n < numDetections; ++n) {
+			auto det = DetectionRing::share(detections, n);
+			peopleDetector::computeAppearance(frame.data(), frameWidth, frameHeight, *det);
+			frameDetections.push_back(det);
+		}
+
+		tracker.setNewDetections(idx, frameDetections);
+		tracker.associate();
+		const uint64_t birthStart = AllocTracker::getPipelineAllocations();
+		const int started = tracker.createNewTracks();
+		if (started > 0) {
+			exempt += AllocTracker::getPipelineAllocations() - birthStart;
+			if (idx >= warmupFrames)
+				births += started;
+		}
+
+		detectionLog.write(idx, frameDetections);
+		checkpoint.update(counter, tracker, idx);
+		archive.update(counter);
+		tracker.getZoneOccupancy(config, zoneOccupancy);
+		publisher.publish(counter, idx, 1, zoneOccupancy, config.numZones);
+		while (crossingEvents.pop(event))
+			;
+
+		const uint64_t allocations = AllocTracker::getPipelineAllocations() - frameStart - exempt;
+		if (idx >= warmupFrames && allocations > 0) {
+			if (allocatingFrames < 10)
+				printf("frame %i: %llu allocations\n", idx, (unsigned long long)allocations);
+			++allocatingFrames;
+			steadyAllocations += allocations;
+		}
+	}
+
+	heatmap.stopExport();
+	detectionLog.close();
+	archive.close();
+	shm_unlink(shmName.c_str());
+	for (const char* name : {"detections.detlog", "checkpoint", "archive", "heatmap.bin"})
+		unlink((prefix + name).c_str());
+	rmdir(dir);
+
+	printf("%i frames (%s), %i warm-up; %i tracks live, %llu started after warm-up; in %i, out %i\n", frames,
+	       threads ? "track threads" : "inline tracks", warmupFrames, tracker.getLiveTrackCount(), (unsigned long long)births,
+	       counter.getEntered(), counter.getLeft());
+	printf("%s  %llu steady-state allocations in %i frames\n", steadyAllocations ? "FAIL" : "PASS", (unsigned long long)steadyAllocations,
+	       allocatingFrames);
+	return steadyAllocations ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+// Range queries on the count archive written by PeopleCounter, e.g. how many
+// entered between 09:00 and 11:30 last Tuesday. Times are local, at the
+// archive's resolution. Without a range, prints the archive's extent and
+// totals.
+//
+// Usage: PeopleCounterArchive <archive> ["YYYY-MM-DD HH:MM" "YYYY-MM-DD HH:MM"]
+
+#include <cstdio>
+#include <ctime>
+
+#include "../peopleDetector/CountArchive.hpp"
+
+using peopleDetector::CountArchive;
+
+static bool parseLocalTime(const char* text, int64_t& ns)
+{
+	tm local = {};
+	const char* end = strptime(text, "%Y-%m-%d %H:%M", &local);
+	if (!end)
+		end = strptime(text, "%Y-%m-%dT%H:%M", &local);
+	if (!end || *end != '\0')
+		return false;
+	local.tm_isdst = -1;
+	ns = (int64_t)mktime(&local) * 1000000000;
+	return true;
+}
+
+static void formatLocalTime(int64_t ns, char* out, size_t size)
+{
+	const time_t seconds = ns / 1000000000;
+	tm local;
+	localtime_r(&seconds, &local);
+	strftime(out, size, "%Y-%m-%d %H:%M", &local);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2 && argc != 4) {
+		printf("usage: %s <archive> [\"YYYY-MM-DD HH:MM\" \"YYYY-MM-DD HH:MM\"]\n", argv[0]);
+		return 2;
+	}
+
+	CountArchive archive(argv[1]);
+	if (!archive.open(false))
+		return 1;
+
+	if (argc == 2) {
+		uint64_t entered = 0, left = 0;
+		char first[32] = "-", last[32] = "-";
+		if (archive.getRecordCount()) {
+			formatLocalTime(archive.getFirstTimeNs(), first, sizeof(first));
+			formatLocalTime(archive.getLastTimeNs(), last, sizeof(last));
+			const int64_t resolutionNs = (int64_t)archive.getResolutionSeconds() * 1000000000;
+			archive.query(archive.getFirstTimeNs(), archive.getLastTimeNs() + resolutionNs, entered, left);
+		}
+		printf("%llu intervals with crossings, %s to %s\nin %llu, out %llu\n", (unsigned long long)archive.getRecordCount(), first, last,
+		       (unsigned long long)entered, (unsigned long long)left);
+		return 0;
+	}
+
+	int64_t fromNs, toNs;
+	if (!parseLocalTime(argv[2], fromNs) || !parseLocalTime(argv[3], toNs)) {
+		printf("times must look like \"2024-05-14 09:00\"\n");
+		return 2;
+	}
+	uint64_t entered = 0, left = 0;
+	if (!archive.query(fromNs, toNs, entered, left))
+		return 1;
+	printf("%s to %s: in %llu, out %llu\n", argv[2], argv[3], (unsigned long long)entered, (unsigned long long)left);
+	return 0;
+}
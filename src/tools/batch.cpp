@@ -0,0 +1,217 @@
+// Offline re-scoring of recorded detection logs (DetectionLogWriter output).
+// Every log is replayed through its own synchronous Tracker and Counter as
+// one task on a work-stealing pool, so a directory of per-camera logs keeps
+// every core busy. Prints the counts of each log and the overall throughput.
+// The config's coverageThreshold and countedClasses filter the recorded
+// detections like the detector would; a log only holds what passed the
+// filter it was recorded with, so a replay can narrow it but not widen it.
+// Class names resolve against the labels file, numeric ids always work.
+//
+// Usage: PeopleCounterBatch <log directory> [config file] [threads] [labels file]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../peopleDetector/ClassMask.hpp"
+#include "../peopleDetector/Config.hpp"
+#include "../peopleDetector/Counter.hpp"
+#include "../peopleDetector/DetectionLog.hpp"
+#include "../peopleDetector/DetectionPool.hpp"
+#include "../peopleDetector/Tracker.hpp"
+#include "../peopleDetector/WorkStealingPool.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::ClassMask;
+using peopleDetector::ConfigWatcher;
+using peopleDetector::Counter;
+using peopleDetector::Detection;
+using peopleDetector::DetectionLogFrame;
+using peopleDetector::DetectionLogReader;
+using peopleDetector::DetectionPool;
+using peopleDetector::Tracker;
+using peopleDetector::WorkStealingPool;
+
+// ################### Settings ###################
+const char* logSuffix = ".detlog";
+const char* defaultLabels = "networks/SSD-Mobilenet-v2/ssd_coco_labels.txt"; // PeopleDetector's default network
+// ################################################
+
+struct LogResult {
+	std::string path;
+	off_t bytes = 0;
+	bool ok = false;
+	uint64_t frames = 0;
+	uint64_t detections = 0;
+	int status = 0, entered = 0, left = 0;
+	int classIds[Counter::maxClasses] = {};
+	int classEntered[Counter::maxClasses] = {};
+	int classLeft[Counter::maxClasses] = {};
+	double seconds = 0;
+};
+
+static bool hasSuffix(const std::string& name, const std::string& suffix)
+{
+	return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// One label per line, as in the network's labels file
+static std::vector<std::string> loadLabels(const std::string& path)
+{
+	std::vector<std::string> labels;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		labels.push_back(line);
+	}
+	return labels;
+}
+
+static void replay(LogResult& result, const ClassMask& classMask, float threshold)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	DetectionLogReader reader;
+	if (!reader.open(result.path))
+		return;
+
+	Counter counter(0);
+	Tracker tracker(counter, true);
+	DetectionPool pool;
+	DetectionLogFrame frame;
+	std::vector<Detection> detections;
+	Tracker::DetectionVec frameDetections;
+
+	int64_t lastFrameId = -1;
+	while (reader.readFrame(frame, detections)) {
+		// Frames missing from the log ran without inference
+		for (int64_t f = lastFrameId + 1; lastFrameId >= 0 && f < frame.frameId; ++f)
+			tracker.elapse(f);
+		lastFrameId = frame.frameId;
+
+		frameDetections.clear();
+		for (Detection& det : detections) {
+			if (det.Confidence < threshold)
+				continue;
+			det.classSlot = classMask.slot(det.ClassID);
+			if (det.classSlot < 0)
+				continue;
+			frameDetections.push_back(pool.acquire(det));
+		}
+
+		tracker.setNewDetections(frame.frameId, frameDetections);
+		tracker.associate();
+		tracker.createNewTracks();
+
+		++result.frames;
+		result.detections += frameDetections.size();
+	}
+
+	result.ok = true;
+	result.status = counter.getStatus();
+	result.entered = counter.getEntered();
+	result.left = counter.getLeft();
+	for (int c = 0; c < Counter::maxClasses; ++c) {
+		result.classIds[c] = counter.getClassId(c);
+		result.classEntered[c] = counter.getEnteredByClass(result.classIds[c]);
+		result.classLeft[c] = counter.getLeftByClass(result.classIds[c]);
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <log directory> [config file] [threads] [labels file]\n", argv[0]);
+		return 2;
+	}
+	const std::string directory = argv[1];
+	const std::string configPath = argc > 2 ? argv[2] : "";
+	const int threads = argc > 3 ? atoi(argv[3]) : 0;
+	const std::string labelsPath = argc > 4 ? argv[4] : defaultLabels;
+
+	// The replay uses this config instead of the one the logs were recorded with
+	ConfigWatcher config(configPath);
+	if (!configPath.empty() && !config.reload()) {
+		fprintf(stderr, "batch: cannot use config %s\n", configPath.c_str());
+		return 2;
+	}
+	const peopleDetector::Config& replayConfig = peopleDetector::currentConfig();
+	const float threshold = replayConfig.coverageThreshold;
+	ClassMask classMask;
+	if (!classMask.compile(replayConfig.countedClasses, loadLabels(labelsPath))) {
+		fprintf(stderr, "batch: no class of '%s' found in %s\n", replayConfig.countedClasses.c_str(), labelsPath.c_str());
+		return 2;
+	}
+
+	std::vector<LogResult> results;
+	DIR* dir = opendir(directory.c_str());
+	if (!dir) {
+		fprintf(stderr, "batch: cannot open %s\n", directory.c_str());
+		return 2;
+	}
+	while (dirent* entry = readdir(dir)) {
+		if (!hasSuffix(entry->d_name, logSuffix))
+			continue;
+		LogResult result;
+		result.path = directory + "/" + entry->d_name;
+		struct stat st;
+		if (stat(result.path.c_str(), &st) == 0)
+			result.bytes = st.st_size;
+		results.push_back(result);
+	}
+	closedir(dir);
+	if (results.empty()) {
+		fprintf(stderr, "batch: no *%s files in %s\n", logSuffix, directory.c_str());
+		return 2;
+	}
+
+	// Largest logs first, stealing then evens out the tail
+	std::sort(results.begin(), results.end(), [](const LogResult& a, const LogResult& b) { return a.bytes > b.bytes; });
+
+	const auto start = std::chrono::steady_clock::now();
+	uint64_t steals;
+	int poolThreads;
+	{
+		WorkStealingPool pool(threads);
+		for (auto& result : results)
+			pool.submit([&result, &classMask, threshold] { replay(result, classMask, threshold); });
+		pool.wait();
+		steals = pool.getSteals();
+		poolThreads = pool.getThreadCount();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::sort(results.begin(), results.end(), [](const LogResult& a, const LogResult& b) { return a.path < b.path; });
+	uint64_t frames = 0, detections = 0;
+	int failed = 0;
+	for (const auto& result : results) {
+		if (!result.ok) {
+			printf("%s  FAILED\n", result.path.c_str());
+			++failed;
+			continue;
+		}
+		printf("%s  frames %llu  detections %llu  status %i  in %i  out %i  %.0f frames/s", result.path.c_str(),
+		       (unsigned long long)result.frames, (unsigned long long)result.detections, result.status, result.entered, result.left,
+		       result.frames / std::max(result.seconds, 1e-9));
+		for (int c = 0; c < Counter::maxClasses; ++c) {
+			if (result.classEntered[c] || result.classLeft[c])
+				printf("  class%i %i/%i", result.classIds[c], result.classEntered[c], result.classLeft[c]);
+		}
+		printf("\n");
+		frames += result.frames;
+		detections += result.detections;
+	}
+	printf("batch: %zu logs, %llu frames, %llu detections in %.2f s on %i threads (%llu steals): %.0f frames/s\n", results.size(),
+	       (unsigned long long)frames, (unsigned long long)detections, seconds, poolThreads, (unsigned long long)steals,
+	       frames / std::max(seconds, 1e-9));
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+// Timing of the CPU work on the frame thread: the kernels on synthetic
+// 1280x720 RGB8 frames (the gstCamera::Create default) and the shared-memory
+// count publication, alone and with readers spinning on the segment, and the
+// crossing events a track thread emits, with the event writer draining and
+// with a stalled consumer. Each benchmark prints mean and p99 per call and
+// fails if the mean exceeds its budget, together with a few behavioural
+// checks.
+//
+// Usage: PeopleCounterBench [motiongate | appearance | seqlock | events] [iterations]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../peopleDetector/Appearance.hpp"
+#include "../peopleDetector/CountPublisher.hpp"
+#include "../peopleDetector/CountReader.hpp"
+#include "../peopleDetector/EventWriter.hpp"
+#include "../peopleDetector/MotionGate.hpp"
+#include "../peopleDetector/TrackedObject.hpp"
+
+std::mutex cout_mtx_;
+
+using peopleDetector::CountPublisher;
+using peopleDetector::Counter;
+using peopleDetector::CountReader;
+using peopleDetector::CrossingEventRing;
+using peopleDetector::Detection;
+using peopleDetector::EventWriter;
+using peopleDetector::MotionGate;
+using peopleDetector::SharedCounts;
+using peopleDetector::TrackedObject;
+using peopleDetector::TrackState;
+
+// ################### Settings ###################
+const int frameWidth = 1280;
+const int frameHeight = 720;
+const double motionGateBudgetUs = 1000.0; // Per frame
+const double appearanceBudgetUs = 50.0;	  // Per 120x300 box
+const double publishBudgetUs = 5.0;	  // Per publication, also with readers spinning
+const double snapshotBudgetUs = 5.0;	  // Per reader snapshot
+const double crossingBudgetUs = 1.0;	  // Per counted crossing with its event, also with the ring full
+const int seqlockReaders = 3;
+const int eventBurst = 1024; // Crossings between pauses for the event writer, a quarter of the ring
+const unsigned seed = 1;
+// ################################################
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	printf("%s  %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		++failures;
+}
+
+static int64_t nowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Mean and p99 of the per-call samples, checked against the budget
+static void report(const char* name, std::vector<int64_t>& samplesNs, double budgetUs)
+{
+	std::sort(samplesNs.begin(), samplesNs.end());
+	double sum = 0;
+	for (int64_t ns : samplesNs)
+		sum += ns;
+	const double meanUs = samplesNs.empty() ? 0.0 : sum / samplesNs.size() / 1000.0;
+	const double p99Us = samplesNs.empty() ? 0.0 : samplesNs[samplesNs.size() * 99 / 100] / 1000.0;
+	printf("  %-12s  mean %8.2f us  p99 %8.2f us  (%zu calls, budget %.0f us)\n", name, meanUs, p99Us, samplesNs.size(), budgetUs);
+
+	char what[96];
+	snprintf(what, sizeof(what), "%s within its budget", name);
+	check(meanUs < budgetUs, what);
+}
+
+// Textured static background, so the sampled luma is not uniform
+static void fillBackground(std::vector<uint8_t>& frame)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> noise(0, 8);
+	for (int y = 0; y < frameHeight; ++y) {
+		for (int x = 0; x < frameWidth; ++x) {
+			uint8_t* px = &frame[3 * (y * frameWidth + x)];
+			px[0] = 60 + (x / 40 % 4) * 20 + noise(rng);
+			px[1] = 80 + (y / 30 % 3) * 25 + noise(rng);
+			px[2] = 70 + noise(rng);
+		}
+	}
+}
+
+static void drawPerson(std::vector<uint8_t>& frame, int left, int top, int width = 60, int height = 160, const uint8_t* colour = nullptr)
+{
+	static const uint8_t light[3] = {220, 210, 200};
+	if (!colour)
+		colour = light;
+	for (int y = std::max(top, 0); y < std::min(top + height, frameHeight); ++y) {
+		for (int x = std::max(left, 0); x < std::min(left + width, frameWidth); ++x) {
+			uint8_t* px = &frame[3 * (y * frameWidth + x)];
+			px[0] = colour[0];
+			px[1] = colour[1];
+			px[2] = colour[2];
+		}
+	}
+}
+
+static Detection box(float left, float top, float width, float height)
+{
+	Detection det;
+	det.Left = left;
+	det.Top = top;
+	det.Right = left + width;
+	det.Bottom = top + height;
+	return det;
+}
+
+static void benchMotionGate(int iterations)
+{
+	printf("motion gate, %dx%d RGB8\n", frameWidth, frameHeight);
+	std::vector<uint8_t> background(3 * frameWidth * frameHeight);
+	fillBackground(background);
+	std::vector<uint8_t> frame = background;
+
+	// Behaviour: an empty scene settles, a walker and someone standing
+	// still are both seen
+	MotionGate gate;
+	bool motion = true;
+	for (int i = 0; i <= gate._holdFrames + 1; ++i)
+		motion = gate.hasMotion(background.data(), frameWidth, frameHeight);
+	check(!motion, "static scene is gated after the hold time");
+
+	bool walkerSeen = true;
+	for (int i = 0; i < 60; ++i) {
+		frame = background;
+		drawPerson(frame, 100 + 10 * i, 300);
+		walkerSeen &= gate.hasMotion(frame.data(), frameWidth, frameHeight);
+	}
+	check(walkerSeen, "walking person is seen on every frame");
+
+	bool standingSeen = true;
+	for (int i = 0; i < 30; ++i)
+		standingSeen &= gate.hasMotion(frame.data(), frameWidth, frameHeight);
+	check(standingSeen, "person standing still is not absorbed within a second");
+
+	// Timing, alternating static and moving frames
+	std::vector<int64_t> samples;
+	samples.reserve(iterations);
+	for (int i = 0; i < iterations; ++i) {
+		frame = background;
+		if (i % 2)
+			drawPerson(frame, i % frameWidth, 200);
+		const int64_t start = nowNs();
+		gate.hasMotion(frame.data(), frameWidth, frameHeight);
+		samples.push_back(nowNs() - start);
+	}
+	report("hasMotion", samples, motionGateBudgetUs);
+}
+
+static void benchAppearance(int iterations)
+{
+	printf("appearance, 120x300 boxes in a %dx%d RGB8 frame\n", frameWidth, frameHeight);
+	std::vector<uint8_t> frame(3 * frameWidth * frameHeight);
+	fillBackground(frame);
+	const uint8_t red[3] = {200, 30, 40};
+	const uint8_t blue[3] = {30, 40, 190};
+	drawPerson(frame, 100, 200, 120, 300, red);
+	drawPerson(frame, 400, 200, 120, 300, blue);
+	drawPerson(frame, 700, 210, 120, 300, red);
+
+	// Behaviour: the same clothes match, different clothes do not
+	Detection first = box(100, 200, 120, 300), other = box(400, 200, 120, 300), again = box(700, 210, 120, 300);
+	for (Detection* det : {&first, &other, &again})
+		peopleDetector::computeAppearance(frame.data(), frameWidth, frameHeight, *det);
+	check(first.hasAppearance && other.hasAppearance && again.hasAppearance, "signatures computed");
+	check(peopleDetector::appearanceSimilarity(first.appearance, again.appearance) > 0.9f, "same clothes are similar");
+	check(peopleDetector::appearanceSimilarity(first.appearance, other.appearance) < 0.5f, "different clothes are not");
+
+	std::vector<int64_t> samples;
+	samples.reserve(iterations);
+	for (int i = 0; i < iterations; ++i) {
+		Detection det = box((i * 37) % (frameWidth - 120), (i * 13) % (frameHeight - 300), 120, 300);
+		const int64_t start = nowNs();
+		peopleDetector::computeAppearance(frame.data(), frameWidth, frameHeight, det);
+		samples.push_back(nowNs() - start);
+	}
+	report("appearance", samples, appearanceBudgetUs);
+}
+
+// Every field is derived from n, so a reader can tell a torn copy
+static void fillCounts(SharedCounts& counts, uint32_t n)
+{
+	memset(&counts, 0, sizeof(counts));
+	counts.timestampNs = n;
+	counts.frameId = n;
+	counts.status = -(int32_t)n;
+	counts.entered = n;
+	counts.left = 2 * n;
+	counts.numGates = peopleDetector::kSharedMaxGates;
+	for (int g = 0; g < peopleDetector::kSharedMaxGates; ++g) {
+		counts.gates[g].entered = n + g;
+		counts.gates[g].left = n - g;
+	}
+	counts.numZones = peopleDetector::kSharedMaxZones;
+	for (int z = 0; z < peopleDetector::kSharedMaxZones; ++z)
+		counts.zones[z].occupancy = n * 3 + z;
+}
+
+static bool consistent(const SharedCounts& counts)
+{
+	SharedCounts expected;
+	fillCounts(expected, counts.frameId);
+	return memcmp(&expected, &counts, sizeof(counts)) == 0;
+}
+
+static void benchSeqlock(int iterations)
+{
+	printf("seqlock publication, alone and with %d spinning readers\n", seqlockReaders);
+	const std::string name = "/peoplecounter-bench-" + std::to_string(getpid());
+	CountPublisher publisher(name);
+	if (!publisher.open()) {
+		check(false, "shared-memory segment created");
+		return;
+	}
+
+	SharedCounts counts;
+	std::vector<int64_t> alone, contended;
+	alone.reserve(iterations);
+	contended.reserve(iterations);
+	uint32_t n = 0;
+	for (int i = 0; i < iterations; ++i) {
+		fillCounts(counts, ++n);
+		const int64_t start = nowNs();
+		publisher.publish(counts);
+		alone.push_back(nowNs() - start);
+	}
+
+	std::atomic<bool> stop{false};
+	std::atomic<uint64_t> snapshots{0}, failed{0}, torn{0};
+	std::vector<std::vector<int64_t>> readerSamples(seqlockReaders);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < seqlockReaders; ++r) {
+		readers.emplace_back([&, r]() {
+			CountReader reader(name);
+			if (!reader.open()) {
+				++failed;
+				return;
+			}
+			SharedCounts out;
+			while (!stop.load(std::memory_order_relaxed)) {
+				const int64_t start = nowNs();
+				const bool ok = reader.snapshot(out);
+				const int64_t ns = nowNs() - start;
+				++snapshots;
+				if (!ok)
+					++failed;
+				else if (!consistent(out))
+					++torn;
+				if ((snapshots.load(std::memory_order_relaxed) & 63) == 0 && readerSamples[r].size() < 1000000)
+					readerSamples[r].push_back(ns); // Sampled, readers outpace the writer by far
+			}
+		});
+	}
+	// Let the readers get going before timing the writer
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	for (int i = 0; i < iterations; ++i) {
+		fillCounts(counts, ++n);
+		const int64_t start = nowNs();
+		publisher.publish(counts);
+		contended.push_back(nowNs() - start);
+		std::this_thread::yield(); // Give the readers a chance on few cores
+	}
+	stop = true;
+	for (auto& reader : readers)
+		reader.join();
+	shm_unlink(name.c_str());
+
+	std::vector<int64_t> snapshotNs;
+	for (const auto& samples : readerSamples)
+		snapshotNs.insert(snapshotNs.end(), samples.begin(), samples.end());
+	report("publish", alone, publishBudgetUs);
+	report("publish+rd", contended, publishBudgetUs);
+	report("snapshot", snapshotNs, snapshotBudgetUs);
+	printf("  %llu snapshots, %llu failed\n", (unsigned long long)snapshots.load(), (unsigned long long)failed.load());
+	check(torn == 0, "readers never accept a torn snapshot");
+	check(failed == 0, "readers always get a snapshot");
+}
+
+// A track that crosses the counting line on every call of updateCounter(),
+// alternately in and out, so each call counts once and emits one event.
+// With burst > 0, every burst crossings are followed by an untimed pause
+// long enough for the event writer to wake up and drain them.
+static void timeCrossings(TrackedObject& track, int iterations, std::vector<int64_t>& samples, int burst = 0, int pauseMs = 0)
+{
+	const float countingLineX = peopleDetector::currentConfig().countingLineX;
+	auto inside = std::make_shared<Detection>(box(countingLineX - 50, 300, 60, 160));
+	auto outside = std::make_shared<Detection>(box(countingLineX + 50, 300, 60, 160));
+	inside->x_mid = countingLineX - 20;
+	outside->x_mid = countingLineX + 80;
+	samples.clear();
+	samples.reserve(iterations);
+	for (int i = 0; i < iterations; ++i) {
+		const std::shared_ptr<Detection>& det = i % 2 ? outside : inside;
+		const int64_t start = nowNs();
+		track.updateCounter(det);
+		samples.push_back(nowNs() - start);
+		if (burst > 0 && (i + 1) % burst == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+	}
+}
+
+static void benchEvents(int iterations)
+{
+	printf("crossing events, counted by a track and pushed to the event ring\n");
+	Counter counter(0);
+	TrackState state = {};
+	state.objectState = peopleDetector::active;
+	state.firstState = (int32_t)peopleDetector::DetectionState::EXITER;
+	for (int i = 0; i < 6; ++i)
+		state.P[7 * i] = 1.0f;
+	TrackedObject track(state, &counter);
+
+	// Writer draining to /dev/null, as main runs it
+	static CrossingEventRing drained;
+	track.setEventRing(&drained);
+	EventWriter writer(drained, "/dev/null");
+	writer.start();
+	std::vector<int64_t> samples;
+	timeCrossings(track, iterations, samples, eventBurst, 2 * writer._idleSleepMs);
+	writer.stop();
+	report("draining", samples, crossingBudgetUs);
+	printf("  %llu written, %llu dropped in the ring\n", (unsigned long long)writer.getWritten(), (unsigned long long)drained.getDropped());
+	check(writer.getWritten() == (uint64_t)iterations && drained.getDropped() == 0, "a draining writer gets every event");
+	check(counter.getEntered() + counter.getLeft() == iterations, "every crossing is counted");
+
+	// Nobody draining and the ring full: every event is dropped
+	static CrossingEventRing stalled;
+	const peopleDetector::CrossingEvent filler = {};
+	while (stalled.push(filler))
+		;
+	track.setEventRing(&stalled);
+	const uint64_t dropped = stalled.getDropped();
+	timeCrossings(track, iterations, samples);
+	report("ring full", samples, crossingBudgetUs);
+	check(stalled.getDropped() - dropped == (uint64_t)iterations, "a full ring drops instead of blocking the track");
+}
+
+int main(int argc, char** argv)
+{
+	const char* only = argc > 1 ? argv[1] : nullptr;
+	const int iterations = argc > 2 ? atoi(argv[2]) : 500;
+
+	if (!only || strcmp(only, "motiongate") == 0)
+		benchMotionGate(iterations);
+	if (!only || strcmp(only, "appearance") == 0)
+		benchAppearance(iterations);
+	if (!only || strcmp(only, "seqlock") == 0)
+		benchSeqlock(iterations * 100);
+	if (!only || strcmp(only, "events") == 0)
+		benchEvents(iterations * 100);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// Self-check of CpuTensorNorm, needs neither camera nor network. Random RGB8
+// and I420 frames of several sizes (odd widths, output rows that are not a
+// multiple of the vector width) go through normBGR() and a plain per-pixel
+// reference of the same nearest-neighbour sampling, BT.601 conversion and
+// range mapping; the NEON / SSE2 paths must match it.
+//
+// Usage: PeopleCounterNorm
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../peopleDetector/TensorNorm.hpp"
+
+using peopleDetector::CpuTensorNorm;
+using peopleDetector::PixelFormat;
+
+// ################### Settings ###################
+const float tolerance = 1e-5f; // Largest difference to the reference
+const unsigned seed = 1;
+// ################################################
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	printf("%s  %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		++failures;
+}
+
+static uint8_t clampByte(int v) { return std::min(std::max(v, 0), 255); }
+
+// BGR of source pixel (sx, sy)
+static void sourcePixel(const uint8_t* pixels, PixelFormat format, uint32_t width, uint32_t height, uint32_t sx, uint32_t sy, uint8_t bgr[3])
+{
+	if (format == PixelFormat::RGB8) {
+		const uint8_t* px = pixels + 3 * ((size_t)sy * width + sx);
+		bgr[0] = px[2];
+		bgr[1] = px[1];
+		bgr[2] = px[0];
+		return;
+	}
+	const uint32_t chromaWidth = (width + 1) / 2;
+	const uint32_t chromaHeight = (height + 1) / 2;
+	const uint8_t* u = pixels + (size_t)width * height;
+	const uint8_t* v = u + (size_t)chromaWidth * chromaHeight;
+	const int c = 298 * (pixels[(size_t)sy * width + sx] - 16);
+	const int d = u[(size_t)(sy / 2) * chromaWidth + sx / 2] - 128;
+	const int e = v[(size_t)(sy / 2) * chromaWidth + sx / 2] - 128;
+	bgr[0] = clampByte((c + 516 * d + 128) >> 8);
+	bgr[1] = clampByte((c - 100 * d - 208 * e + 128) >> 8);
+	bgr[2] = clampByte((c + 409 * e + 128) >> 8);
+}
+
+static float maxError(CpuTensorNorm& norm, PixelFormat format, uint32_t width, uint32_t height, uint32_t outputWidth, uint32_t outputHeight,
+		      float rangeMin, float rangeMax, std::mt19937& rng)
+{
+	std::vector<uint8_t> pixels(peopleDetector::pixelFormatSize(format, width, height));
+	std::uniform_int_distribution<int> byte(0, 255);
+	for (uint8_t& p : pixels)
+		p = byte(rng);
+
+	const size_t plane = (size_t)outputWidth * outputHeight;
+	std::vector<float> output(3 * plane);
+	if (!norm.normBGR(pixels.data(), format, width, height, output.data(), outputWidth, outputHeight, rangeMin, rangeMax))
+		return INFINITY;
+
+	const float scaleX = (float)width / outputWidth;
+	const float scaleY = (float)height / outputHeight;
+	float error = 0;
+	for (uint32_t y = 0; y < outputHeight; ++y) {
+		const uint32_t sy = std::min((uint32_t)(y * scaleY), height - 1);
+		for (uint32_t x = 0; x < outputWidth; ++x) {
+			const uint32_t sx = std::min((uint32_t)(x * scaleX), width - 1);
+			uint8_t bgr[3];
+			sourcePixel(pixels.data(), format, width, height, sx, sy, bgr);
+			for (int c = 0; c < 3; ++c) {
+				const float expected = rangeMin + bgr[c] * (rangeMax - rangeMin) / 255.0f;
+				error = std::max(error, std::fabs(output[c * plane + (size_t)y * outputWidth + x] - expected));
+			}
+		}
+	}
+	return error;
+}
+
+int main()
+{
+	struct Case {
+		PixelFormat format;
+		uint32_t width, height, outputWidth, outputHeight;
+		float rangeMin, rangeMax;
+	};
+	const Case cases[] = {
+	    {PixelFormat::RGB8, 1280, 720, 300, 300, -1.0f, 1.0f}, // SSD-Mobilenet input
+	    {PixelFormat::I420, 1280, 720, 300, 300, -1.0f, 1.0f},
+	    {PixelFormat::RGB8, 641, 357, 37, 29, 0.0f, 1.0f}, // Odd sizes, vector tails
+	    {PixelFormat::I420, 641, 357, 37, 29, 0.0f, 1.0f},
+	    {PixelFormat::RGB8, 160, 120, 320, 240, -1.0f, 1.0f}, // Upscaling
+	    {PixelFormat::I420, 15, 9, 17, 3, -1.0f, 1.0f},	    // Shorter than one vector
+	};
+
+	std::mt19937 rng(seed);
+	CpuTensorNorm norm;
+	for (const Case& c : cases) {
+		const float error =
+		    maxError(norm, c.format, c.width, c.height, c.outputWidth, c.outputHeight, c.rangeMin, c.rangeMax, rng);
+		char what[128];
+		snprintf(what, sizeof(what), "%s %ux%u -> %ux%u [%g, %g] matches the reference (max error %g)",
+			 c.format == PixelFormat::I420 ? "I420" : "RGB8", c.width, c.height, c.outputWidth, c.outputHeight, c.rangeMin,
+			 c.rangeMax, error);
+		check(error <= tolerance, what);
+	}
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// End-to-end benchmark of the frame path on a CPU-only machine. Frames come
+// zero-copy from a memory-mapped raw video (MappedVideoSource), are turned
+// into the network's input tensor by the CPU equivalent of cudaTensorNormBGR
+// (CpuTensorNorm), then a detector stub reports synthetic people crossing
+// the counting line, which a synchronous Tracker tracks and counts. Prints
+// per-stage latency, the overall frame rate and the counts.
+//
+// Usage: PeopleCounterPipeline <video.y4m | video.rgb> [width height] [frames]
+//        width and height are needed for raw RGB8 files only; the video
+//        loops until frames have been processed (default: one pass)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../peopleDetector/Counter.hpp"
+#include "../peopleDetector/DetectionPool.hpp"
+#include "../peopleDetector/MappedVideoSource.hpp"
+#include "../peopleDetector/Metrics.hpp"
+#include "../peopleDetector/TensorNorm.hpp"
+#include "../peopleDetector/Tracker.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::Counter;
+using peopleDetector::CpuTensorNorm;
+using peopleDetector::Detection;
+using peopleDetector::DetectionPool;
+using peopleDetector::LatencyHistogram;
+using peopleDetector::MappedVideoSource;
+using peopleDetector::Tracker;
+using peopleDetector::VideoFrame;
+
+// ################### Settings ###################
+const uint32_t inputWidth = 300; // SSD-Mobilenet input, Dims3(3, 300, 300)
+const uint32_t inputHeight = 300;
+const double spawnProbability = 1.0 / 20; // New person per frame
+const double missProbability = 0.05;
+const unsigned seed = 1;
+// ################################################
+
+enum BenchStage { CAPTURE, PREPROCESS, DETECT, TRACK, NUM_STAGES };
+static const char* stageNames[NUM_STAGES] = {"capture", "preprocess", "detect", "track"};
+
+struct Walker {
+	float x, y, vx;
+};
+
+// Stands in for the network: people walking across the frame, reported
+// with a few misses. Reads a sparse sample of the tensor, so the
+// preprocessing output is consumed like a real backend would.
+class DetectorStub
+{
+      public:
+	DetectorStub(uint32_t width, uint32_t height) : _width(width), _height(height), _rng(seed) {}
+
+	float detect(const float* tensor, Tracker::DetectionVec& detections)
+	{
+		float checksum = 0;
+		for (size_t i = 0; i < 3 * inputWidth * inputHeight; i += 997)
+			checksum += tensor[i];
+
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		if (uniform(_rng) < spawnProbability) {
+			const bool fromLeft = uniform(_rng) < 0.5f;
+			const float speed = 3.0f + 5.0f * uniform(_rng);
+			_walkers.push_back({fromLeft ? 0.0f : (float)_width, _height * (0.2f + 0.6f * uniform(_rng)), fromLeft ? speed : -speed});
+		}
+		for (auto& walker : _walkers)
+			walker.x += walker.vx;
+		_walkers.erase(std::remove_if(_walkers.begin(), _walkers.end(),
+					      [this](const Walker& w) { return w.x < -50.0f || w.x > _width + 50.0f; }),
+			       _walkers.end());
+
+		detections.clear();
+		for (const auto& walker : _walkers) {
+			if (uniform(_rng) < missProbability)
+				continue;
+			Detection det;
+			det.Left = walker.x - 30;
+			det.Right = walker.x + 30;
+			det.Top = walker.y - 80;
+			det.Bottom = walker.y + 80;
+			det.ClassID = 1;
+			det.Confidence = 0.9f;
+			detections.push_back(_pool.acquire(det));
+		}
+		return checksum;
+	}
+
+      private:
+	uint32_t _width, _height;
+	std::mt19937 _rng;
+	std::vector<Walker> _walkers;
+	DetectionPool _pool;
+};
+
+static int64_t nowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		printf("usage: %s <video.y4m | video.rgb> [width height] [frames]\n", argv[0]);
+		return 2;
+	}
+	const bool rawSize = argc > 3;
+	const uint32_t width = rawSize ? atoi(argv[2]) : 0;
+	const uint32_t height = rawSize ? atoi(argv[3]) : 0;
+	const char* framesArg = rawSize ? (argc > 4 ? argv[4] : nullptr) : (argc > 2 ? argv[2] : nullptr);
+
+	MappedVideoSource source;
+	if (!source.open(argv[1], width, height))
+		return 1;
+	const uint64_t frames = framesArg ? strtoull(framesArg, nullptr, 10) : source.getFrameCount();
+	source.setLoop(true);
+
+	static Counter counter(0);
+	Tracker tracker(counter, true);
+	CpuTensorNorm tensorNorm;
+	DetectorStub detector(source.getWidth(), source.getHeight());
+	std::vector<float> tensor(3 * inputWidth * inputHeight);
+	Tracker::DetectionVec frameDetections;
+
+	LatencyHistogram latency[NUM_STAGES];
+	uint64_t totalNs[NUM_STAGES] = {};
+	double checksum = 0;
+
+	const int64_t start = nowNs();
+	for (uint64_t frame = 0; frame < frames; ++frame) {
+		int64_t t0 = nowNs();
+		VideoFrame video;
+		if (!source.next(video))
+			break;
+		int64_t t1 = nowNs();
+		latency[CAPTURE].record(t1 - t0);
+		totalNs[CAPTURE] += t1 - t0;
+
+		tensorNorm.normBGR(video.data, video.format, video.width, video.height, tensor.data(), inputWidth, inputHeight);
+		t0 = nowNs();
+		latency[PREPROCESS].record(t0 - t1);
+		totalNs[PREPROCESS] += t0 - t1;
+
+		checksum += detector.detect(tensor.data(), frameDetections);
+		t1 = nowNs();
+		latency[DETECT].record(t1 - t0);
+		totalNs[DETECT] += t1 - t0;
+
+		tracker.setNewDetections(frame, frameDetections);
+		tracker.associate();
+		tracker.createNewTracks();
+		t0 = nowNs();
+		latency[TRACK].record(t0 - t1);
+		totalNs[TRACK] += t0 - t1;
+	}
+	const double seconds = (nowNs() - start) / 1e9;
+
+	printf("%llu frames of %ux%u %s in %.2f s, %.1f fps (tensor checksum %.3f)\n", (unsigned long long)frames, source.getWidth(),
+	       source.getHeight(), source.getFormat() == peopleDetector::PixelFormat::I420 ? "I420" : "RGB8", seconds, frames / seconds,
+	       checksum);
+	for (int s = 0; s < NUM_STAGES; ++s) {
+		printf("  %-10s  p50 %6u us  p99 %6u us  mean %8.2f us\n", stageNames[s], latency[s].percentileUs(0.5),
+		       latency[s].percentileUs(0.99), frames ? totalNs[s] / 1000.0 / frames : 0.0);
+	}
+	printf("status %i, in %i, out %i\n", counter.getStatus(), counter.getEntered(), counter.getLeft());
+	return 0;
+}
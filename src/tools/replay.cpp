@@ -0,0 +1,364 @@
+// Differential replay of a recorded detection log (DetectionLogWriter
+// output) through two tracker configurations in lockstep. Both sides get
+// the same detections each frame; after every frame their confirmed
+// tracks, the track each detection was associated to and the counts are
+// compared. Track ids come from a process-wide allocator, so they are
+// compared as labels in order of first appearance. Prints the first
+// divergent frame in detail, a divergence summary and per-stage timings
+// of both sides next to each other.
+//
+// To compare two builds instead of two configs, save the results of one
+// build with --save and replay the other against them with --against.
+// --pool associates side B on a pool of that many threads, from min tracks
+// live tracks on (default Tracker::defaultParallelMinTracks): with the same
+// config on both sides any divergence is a bug of the parallel association.
+//
+// Usage: PeopleCounterReplay <log> <config A | -> <config B | -> [--save trace] [--pool threads [min tracks]]
+//        PeopleCounterReplay <log> <config A | -> --against trace
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../peopleDetector/Config.hpp"
+#include "../peopleDetector/Counter.hpp"
+#include "../peopleDetector/DetectionLog.hpp"
+#include "../peopleDetector/DetectionPool.hpp"
+#include "../peopleDetector/Metrics.hpp"
+#include "../peopleDetector/Tracker.hpp"
+#include "../peopleDetector/WorkStealingPool.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::Config;
+using peopleDetector::Counter;
+using peopleDetector::Detection;
+using peopleDetector::DetectionLogFrame;
+using peopleDetector::DetectionLogReader;
+using peopleDetector::DetectionPool;
+using peopleDetector::LatencyHistogram;
+using peopleDetector::ScopedConfig;
+using peopleDetector::Tracker;
+using peopleDetector::TrackState;
+using peopleDetector::WorkStealingPool;
+
+// ################### Settings ###################
+const float positionTolerance = 0.01f; // px, absorbs float reassociation in refactored maths
+const int maxTrackStates = 256;
+const uint32_t traceMagic = 0x54524350; // "PCRT"
+// ################################################
+
+enum ReplayStage { SET_DETECTIONS, ASSOCIATE, CREATE_TRACKS, TOTAL, NUM_STAGES };
+static const char* stageNames[NUM_STAGES] = {"setNewDetections", "associate", "createNewTracks", "frame"};
+
+struct TrackSnapshot {
+	int32_t label;
+	int32_t objectState;
+	float x, y;
+};
+
+// Everything compared per frame, also the record format of trace files
+struct FrameResult {
+	uint32_t frameId = 0;
+	int32_t status = 0, entered = 0, left = 0;
+	std::vector<TrackSnapshot> tracks;    // Confirmed tracks, by label
+	std::vector<int32_t> detectionLabels; // Track label of each detection after associate(), -1 if unassociated
+};
+
+// One tracker configuration with its own counter and track labels
+class Side
+{
+      public:
+	Side(const Config& config) : _config(config), _tracker(_counter, true), _states(maxTrackStates) {}
+
+	inline void setAssociationPool(WorkStealingPool* pool, int minTracks) { _tracker.setAssociationPool(pool, minTracks); }
+
+	void step(const DetectionLogFrame& frame, const std::vector<Detection>& detections, FrameResult& result)
+	{
+		ScopedConfig scoped(_config);
+
+		// Frames missing from the log ran without inference
+		for (int64_t f = _lastFrameId + 1; _lastFrameId >= 0 && f < frame.frameId; ++f)
+			_tracker.elapse(f);
+		_lastFrameId = frame.frameId;
+
+		_frameDetections.clear();
+		for (const Detection& det : detections)
+			_frameDetections.push_back(_pool.acquire(det));
+
+		const auto t0 = std::chrono::steady_clock::now();
+		_tracker.setNewDetections(frame.frameId, _frameDetections);
+		const auto t1 = std::chrono::steady_clock::now();
+		_tracker.associate();
+		const auto t2 = std::chrono::steady_clock::now();
+		result.detectionLabels.clear();
+		for (const auto& det : _frameDetections)
+			result.detectionLabels.push_back(det->associated ? label(det->trackId) : -1);
+		const auto t3 = std::chrono::steady_clock::now();
+		_tracker.createNewTracks();
+		const auto t4 = std::chrono::steady_clock::now();
+		observe(SET_DETECTIONS, t1 - t0);
+		observe(ASSOCIATE, t2 - t1);
+		observe(CREATE_TRACKS, t4 - t3);
+		observe(TOTAL, (t4 - t3) + (t2 - t0));
+
+		result.frameId = frame.frameId;
+		result.status = _counter.getStatus();
+		result.entered = _counter.getEntered();
+		result.left = _counter.getLeft();
+		const int numStates = _tracker.getTrackStates(_states.data(), maxTrackStates);
+		result.tracks.clear();
+		for (int i = 0; i < numStates; ++i)
+			result.tracks.push_back({label(_states[i].id), _states[i].objectState, _states[i].X[0], _states[i].X[1]});
+		std::sort(result.tracks.begin(), result.tracks.end(),
+			  [](const TrackSnapshot& x, const TrackSnapshot& y) { return x.label < y.label; });
+	}
+
+	inline const LatencyHistogram& latency(int stage) const { return _latency[stage]; }
+	inline double meanUs(int stage, uint64_t frames) const { return frames ? _totalNs[stage] / 1000.0 / frames : 0.0; }
+	inline int getTrackCount() const { return _labels.size(); }
+
+      private:
+	int32_t label(int trackId)
+	{
+		auto it = _labels.find(trackId);
+		if (it == _labels.end())
+			it = _labels.emplace(trackId, (int32_t)_labels.size()).first;
+		return it->second;
+	}
+
+	void observe(int stage, std::chrono::steady_clock::duration elapsed)
+	{
+		const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+		_latency[stage].record(ns);
+		_totalNs[stage] += ns;
+	}
+
+	Config _config;
+	Counter _counter{0};
+	Tracker _tracker;
+	DetectionPool _pool;
+	Tracker::DetectionVec _frameDetections;
+	std::vector<TrackState> _states;
+	int64_t _lastFrameId = -1;
+	std::unordered_map<int, int32_t> _labels;
+	LatencyHistogram _latency[NUM_STAGES];
+	uint64_t _totalNs[NUM_STAGES] = {};
+};
+
+static bool loadConfig(const char* path, Config& config)
+{
+	if (strcmp(path, "-") == 0)
+		return true;
+	if (!peopleDetector::parseConfig(path, config)) {
+		fprintf(stderr, "replay: cannot use config %s\n", path);
+		return false;
+	}
+	return true;
+}
+
+static void writeResult(FILE* file, const FrameResult& r)
+{
+	const uint32_t numTracks = r.tracks.size(), numDetections = r.detectionLabels.size();
+	const int32_t counts[3] = {r.status, r.entered, r.left};
+	fwrite(&r.frameId, sizeof(r.frameId), 1, file);
+	fwrite(counts, sizeof(counts), 1, file);
+	fwrite(&numTracks, sizeof(numTracks), 1, file);
+	fwrite(&numDetections, sizeof(numDetections), 1, file);
+	fwrite(r.tracks.data(), sizeof(TrackSnapshot), numTracks, file);
+	fwrite(r.detectionLabels.data(), sizeof(int32_t), numDetections, file);
+}
+
+static bool readResult(FILE* file, FrameResult& r)
+{
+	int32_t counts[3];
+	uint32_t numTracks, numDetections;
+	if (fread(&r.frameId, sizeof(r.frameId), 1, file) != 1 || fread(counts, sizeof(counts), 1, file) != 1 ||
+	    fread(&numTracks, sizeof(numTracks), 1, file) != 1 || fread(&numDetections, sizeof(numDetections), 1, file) != 1)
+		return false;
+	r.status = counts[0];
+	r.entered = counts[1];
+	r.left = counts[2];
+	r.tracks.resize(numTracks);
+	r.detectionLabels.resize(numDetections);
+	return fread(r.tracks.data(), sizeof(TrackSnapshot), numTracks, file) == numTracks &&
+	       fread(r.detectionLabels.data(), sizeof(int32_t), numDetections, file) == numDetections;
+}
+
+// What differs between two frame results, empty if they match
+static std::string compare(const FrameResult& a, const FrameResult& b, bool& countsDiffer)
+{
+	std::string diff;
+	char line[256];
+	countsDiffer = a.status != b.status || a.entered != b.entered || a.left != b.left;
+	if (countsDiffer) {
+		snprintf(line, sizeof(line), "    counts: A status %i in %i out %i, B status %i in %i out %i\n", a.status, a.entered, a.left,
+			 b.status, b.entered, b.left);
+		diff += line;
+	}
+	for (size_t i = 0; i < std::max(a.detectionLabels.size(), b.detectionLabels.size()); ++i) {
+		const int la = i < a.detectionLabels.size() ? a.detectionLabels[i] : -2;
+		const int lb = i < b.detectionLabels.size() ? b.detectionLabels[i] : -2;
+		if (la != lb) {
+			snprintf(line, sizeof(line), "    detection %zu: A track %i, B track %i\n", i, la, lb);
+			diff += line;
+		}
+	}
+	// Tracks matched by label, both lists are sorted
+	size_t i = 0, j = 0;
+	while (i < a.tracks.size() || j < b.tracks.size()) {
+		const TrackSnapshot* ta = i < a.tracks.size() ? &a.tracks[i] : nullptr;
+		const TrackSnapshot* tb = j < b.tracks.size() ? &b.tracks[j] : nullptr;
+		if (ta && (!tb || ta->label < tb->label)) {
+			snprintf(line, sizeof(line), "    track #%i: only in A, state %i at (%.3f, %.3f)\n", ta->label, ta->objectState, ta->x,
+				 ta->y);
+			++i;
+		} else if (tb && (!ta || tb->label < ta->label)) {
+			snprintf(line, sizeof(line), "    track #%i: only in B, state %i at (%.3f, %.3f)\n", tb->label, tb->objectState, tb->x,
+				 tb->y);
+			++j;
+		} else {
+			++i;
+			++j;
+			if (ta->objectState == tb->objectState && std::fabs(ta->x - tb->x) <= positionTolerance &&
+			    std::fabs(ta->y - tb->y) <= positionTolerance)
+				continue;
+			snprintf(line, sizeof(line), "    track #%i: A state %i at (%.3f, %.3f), B state %i at (%.3f, %.3f)\n", ta->label,
+				 ta->objectState, ta->x, ta->y, tb->objectState, tb->x, tb->y);
+		}
+		diff += line;
+	}
+	return diff;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 4) {
+		fprintf(stderr, "usage: %s <log> <config A | -> <config B | -> [--save trace] [--pool threads [min tracks]]\n", argv[0]);
+		fprintf(stderr, "       %s <log> <config A | -> --against trace\n", argv[0]);
+		return 2;
+	}
+	const bool against = strcmp(argv[3], "--against") == 0;
+	const char* tracePath = against ? (argc > 4 ? argv[4] : nullptr) : (argc > 5 && strcmp(argv[4], "--save") == 0 ? argv[5] : nullptr);
+	if (against && !tracePath) {
+		fprintf(stderr, "replay: --against needs a trace file\n");
+		return 2;
+	}
+	int poolThreads = 0, poolMinTracks = Tracker::defaultParallelMinTracks;
+	for (int i = tracePath ? 6 - against : 4; i < argc; ++i) {
+		if (strcmp(argv[i], "--pool") == 0 && !against && i + 1 < argc) {
+			poolThreads = atoi(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				poolMinTracks = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "replay: unexpected argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (poolThreads < 0 || (poolThreads > 0 && poolMinTracks < 1)) {
+		fprintf(stderr, "replay: --pool needs a thread count and at least one track\n");
+		return 2;
+	}
+
+	Config configA, configB;
+	if (!loadConfig(argv[2], configA) || (!against && !loadConfig(argv[3], configB)))
+		return 2;
+
+	DetectionLogReader reader;
+	if (!reader.open(argv[1]))
+		return 2;
+
+	FILE* trace = nullptr;
+	if (tracePath) {
+		trace = fopen(tracePath, against ? "rb" : "wb");
+		uint32_t magic = traceMagic;
+		if (trace && against && (fread(&magic, sizeof(magic), 1, trace) != 1 || magic != traceMagic)) {
+			fclose(trace);
+			trace = nullptr;
+		} else if (trace && !against) {
+			fwrite(&magic, sizeof(magic), 1, trace);
+		}
+		if (!trace) {
+			fprintf(stderr, "replay: cannot use trace %s\n", tracePath);
+			return 2;
+		}
+	}
+
+	Side sideA(configA);
+	Side sideB(configB);
+	std::unique_ptr<WorkStealingPool> pool;
+	if (poolThreads > 0) {
+		pool.reset(new WorkStealingPool(poolThreads));
+		sideB.setAssociationPool(pool.get(), poolMinTracks);
+		printf("side B associates on %i pool threads from %i live tracks\n", poolThreads, poolMinTracks);
+	}
+	DetectionLogFrame frame;
+	std::vector<Detection> detections;
+	FrameResult resultA, resultB;
+	uint64_t frames = 0, divergentFrames = 0, countDivergentFrames = 0;
+	int64_t firstDivergence = -1, firstCountDivergence = -1;
+	bool traceEnded = false;
+
+	while (reader.readFrame(frame, detections)) {
+		sideA.step(frame, detections, resultA);
+		if (against) {
+			if (!readResult(trace, resultB)) {
+				traceEnded = true;
+				break;
+			}
+		} else {
+			sideB.step(frame, detections, resultB);
+			if (trace)
+				writeResult(trace, resultA);
+		}
+		++frames;
+
+		bool countsDiffer;
+		const std::string diff = compare(resultA, resultB, countsDiffer);
+		if (diff.empty())
+			continue;
+		++divergentFrames;
+		if (countsDiffer) {
+			++countDivergentFrames;
+			if (firstCountDivergence < 0)
+				firstCountDivergence = frame.frameId;
+		}
+		if (firstDivergence < 0) {
+			firstDivergence = frame.frameId;
+			printf("first divergence at frame %u (%zu detections):\n%s", frame.frameId, detections.size(), diff.c_str());
+		}
+	}
+	if (trace)
+		fclose(trace);
+
+	printf("%llu frames replayed%s\n", (unsigned long long)frames, traceEnded ? ", trace ended early" : "");
+	if (firstDivergence < 0) {
+		printf("no divergence: tracks, associations and counts match on every frame\n");
+	} else {
+		printf("%llu divergent frames, first at %lli; counts first differ at %lli (%llu frames)\n", (unsigned long long)divergentFrames,
+		       (long long)firstDivergence, (long long)firstCountDivergence, (unsigned long long)countDivergentFrames);
+	}
+	printf("final counts: A status %i in %i out %i, B status %i in %i out %i\n", resultA.status, resultA.entered, resultA.left,
+	       resultB.status, resultB.entered, resultB.left);
+	if (!against)
+		printf("tracks started: A %i, B %i\n", sideA.getTrackCount(), sideB.getTrackCount());
+
+	printf("%-18s %28s %28s %8s\n", "stage", "A p50 / p99 / mean us", against ? "" : "B p50 / p99 / mean us", against ? "" : "B/A");
+	for (int s = 0; s < NUM_STAGES; ++s) {
+		const double meanA = sideA.meanUs(s, frames);
+		printf("%-18s %8u %8u %10.2f", stageNames[s], sideA.latency(s).percentileUs(0.5), sideA.latency(s).percentileUs(0.99), meanA);
+		if (!against) {
+			const double meanB = sideB.meanUs(s, frames);
+			printf(" %8u %8u %10.2f %8.2f", sideB.latency(s).percentileUs(0.5), sideB.latency(s).percentileUs(0.99), meanB,
+			       meanA > 0 ? meanB / meanA : 0.0);
+		}
+		printf("\n");
+	}
+	return firstDivergence < 0 ? 0 : 1;
+}
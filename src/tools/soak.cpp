@@ -0,0 +1,235 @@
+// Long-run soak test of the tracking stage. Feeds synthetic people crossing
+// the counting line through Tracker / TrackedObject, with every skipEvery-th
+// frame run without inference as under load shedding, samples resource usage
+// at a fixed frame interval and fails if any of it keeps growing. Checks
+// first that a new track survives a frame without inference.
+//
+// Usage: PeopleCounterSoak [frames] [sampleEvery] [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../peopleDetector/Counter.hpp"
+#include "../peopleDetector/DetectionPool.hpp"
+#include "../peopleDetector/Metrics.hpp"
+#include "../peopleDetector/Tracker.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::Counter;
+using peopleDetector::Detection;
+using peopleDetector::DetectionPool;
+using peopleDetector::LatencyHistogram;
+using peopleDetector::Tracker;
+
+// ################### Settings ###################
+const int frameWidth = 1280;
+const int frameHeight = 720;
+const double spawnProbability = 1.0 / 40; // New person per frame
+const double missProbability = 0.05;	  // Detection dropped (occlusion)
+const float boxNoise = 3.0f;		  // px
+const double warmupFraction = 0.1;	  // Samples ignored by the growth check
+const uint64_t skipEvery = 5;		  // Frames without inference (Tracker::elapse)
+// ################################################
+
+struct Walker {
+	float x, y, vx;
+};
+
+struct Sample {
+	uint64_t frame;
+	long rssKb;
+	int threads;
+	int tracks;
+	int liveTracks;
+	size_t poolSize;
+	uint32_t p50Us, p99Us;
+	double meanUs;
+};
+
+static long readRssKb()
+{
+	std::ifstream statm("/proc/self/statm");
+	long pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int readThreadCount()
+{
+	std::ifstream status("/proc/self/status");
+	std::string key;
+	while (status >> key) {
+		if (key == "Threads:") {
+			int threads = 0;
+			status >> threads;
+			return threads;
+		}
+	}
+	return -1;
+}
+
+// Compare the worst value of the second half of the samples against the
+// first half; anything bounded stays within tolerance, a leak does not.
+template <class Get> static bool checkGrowth(const std::vector<Sample>& samples, const char* name, double factor, double slack, Get get)
+{
+	const size_t begin = samples.size() * warmupFraction;
+	const size_t mid = begin + (samples.size() - begin) / 2;
+	double first = 0, second = 0;
+	for (size_t i = begin; i < mid; ++i)
+		first = std::max(first, (double)get(samples[i]));
+	for (size_t i = mid; i < samples.size(); ++i)
+		second = std::max(second, (double)get(samples[i]));
+
+	const bool ok = second <= first * factor + slack;
+	printf("  %-12s first half max %10.2f  second half max %10.2f  %s\n", name, first, second, ok ? "ok" : "GROWING");
+	return ok;
+}
+
+static std::shared_ptr<Detection> person(DetectionPool& pool, float x, float y)
+{
+	Detection det;
+	det.Left = x - 30;
+	det.Right = x + 30;
+	det.Top = y - 80;
+	det.Bottom = y + 80;
+	det.ClassID = 1;
+	det.Confidence = 0.9f;
+	return pool.acquire(det);
+}
+
+// A track seen once, then a frame without inference, must take the next
+// detection instead of being dropped as a missed init track
+static bool checkInferenceSkip()
+{
+	Counter counter(0);
+	Tracker tracker(counter, true);
+	DetectionPool pool;
+	Tracker::DetectionVec frameDetections;
+
+	frameDetections.push_back(person(pool, 300, 360));
+	tracker.setNewDetections(0, frameDetections);
+	tracker.associate();
+	const int born = tracker.createNewTracks();
+	tracker.elapse(1);
+	frameDetections.clear();
+	frameDetections.push_back(person(pool, 310, 360));
+	tracker.setNewDetections(2, frameDetections);
+	tracker.associate();
+	const int reborn = tracker.createNewTracks();
+
+	const bool ok = born == 1 && reborn == 0 && tracker.getLiveTrackCount() == 1 && frameDetections[0]->associated;
+	printf("inference skip: %s\n", ok ? "track kept" : "track lost");
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	const uint64_t frames = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+	const uint64_t sampleEvery = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000;
+	const unsigned seed = argc > 3 ? atoi(argv[3]) : 1;
+
+	static Counter counter(0);
+	Tracker tracker(counter);
+	DetectionPool pool;
+	Tracker::DetectionVec frameDetections;
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::uniform_real_distribution<float> speed(3.0f, 8.0f);
+	std::uniform_real_distribution<float> row(150.0f, frameHeight - 150.0f);
+	std::normal_distribution<float> noise(0.0f, boxNoise);
+	std::vector<Walker> walkers;
+	walkers.reserve(64);
+
+	LatencyHistogram window;
+	uint64_t windowNs = 0;
+	std::vector<Sample> samples;
+	samples.reserve(frames / sampleEvery + 1);
+
+	if (!checkInferenceSkip()) {
+		printf("soak: FAIL\n");
+		return 1;
+	}
+
+	printf("soak: %llu frames, sample every %llu, seed %u\n", (unsigned long long)frames, (unsigned long long)sampleEvery, seed);
+	for (uint64_t frame = 0; frame < frames; ++frame) {
+		// Advance the synthetic scene
+		if (uniform(rng) < spawnProbability) {
+			const bool fromLeft = uniform(rng) < 0.5;
+			walkers.push_back({fromLeft ? 0.0f : (float)frameWidth, row(rng), fromLeft ? speed(rng) : -speed(rng)});
+		}
+		for (auto& walker : walkers)
+			walker.x += walker.vx;
+		walkers.erase(std::remove_if(walkers.begin(), walkers.end(),
+					     [](const Walker& w) { return w.x < -50.0f || w.x > frameWidth + 50.0f; }),
+			      walkers.end());
+
+		const bool inferred = frame % skipEvery != skipEvery - 1;
+		frameDetections.clear();
+		for (const auto& walker : walkers) {
+			if (!inferred || uniform(rng) < missProbability)
+				continue;
+			frameDetections.push_back(person(pool, walker.x + noise(rng), walker.y + noise(rng)));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if (inferred) {
+			tracker.setNewDetections(frame, frameDetections);
+			tracker.associate();
+			tracker.createNewTracks();
+		} else {
+			tracker.elapse(frame);
+		}
+		const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		window.record(ns);
+		windowNs += ns;
+
+		if ((frame + 1) % sampleEvery == 0) {
+			Sample sample;
+			sample.frame = frame + 1;
+			sample.rssKb = readRssKb();
+			sample.threads = readThreadCount();
+			sample.tracks = tracker.getTrackCount();
+			sample.liveTracks = tracker.getLiveTrackCount();
+			sample.poolSize = pool.size();
+			sample.p50Us = window.percentileUs(0.5);
+			sample.p99Us = window.percentileUs(0.99);
+			sample.meanUs = windowNs / 1000.0 / sampleEvery;
+			samples.push_back(sample);
+			window.reset();
+			windowNs = 0;
+
+			printf("frame %12llu  rss %7ld kB  threads %4d  tracks %4d  live %4d  pool %4zu  p50 %6u us  p99 %6u us  mean %8.2f us\n",
+			       (unsigned long long)sample.frame, sample.rssKb, sample.threads, sample.tracks, sample.liveTracks, sample.poolSize,
+			       sample.p50Us, sample.p99Us, sample.meanUs);
+			fflush(stdout);
+		}
+	}
+
+	printf("status %i, in %i, out %i\n", counter.getStatus(), counter.getEntered(), counter.getLeft());
+	if (samples.size() < 8) {
+		printf("soak: too few samples for a growth check\n");
+		fflush(stdout);
+		_exit(2);
+	}
+
+	bool ok = true;
+	printf("growth check:\n");
+	ok &= checkGrowth(samples, "rss kB", 1.1, 2048, [](const Sample& s) { return s.rssKb; });
+	ok &= checkGrowth(samples, "threads", 1.5, 8, [](const Sample& s) { return s.threads; });
+	ok &= checkGrowth(samples, "tracks", 1.5, 8, [](const Sample& s) { return s.tracks; });
+	ok &= checkGrowth(samples, "pool", 1.5, 8, [](const Sample& s) { return s.poolSize; });
+	ok &= checkGrowth(samples, "mean us", 2.0, 5, [](const Sample& s) { return s.meanUs; });
+	printf("soak: %s\n", ok ? "PASS" : "FAIL");
+	fflush(stdout);
+
+	// Live track threads are parked in receive(); skip their teardown
+	_exit(ok ? 0 : 1);
+}
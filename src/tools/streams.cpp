@@ -0,0 +1,176 @@
+// Multi-stream benchmark of the tracking stage. Synthetic people cross the
+// frame of every stream at very different rates (a busy entrance next to
+// quiet back doors); each tick submits one frame per stream to a
+// StreamExecutor and waits for all of them, like a process serving several
+// cameras. Prints the tick latency, per-stream counts and the pool's
+// utilisation and steal statistics.
+//
+// Then checks fairness on a single worker: stream 0 gets a backlog of
+// frames, the others one frame each. The others must be processed while
+// most of the backlog is still waiting, not after it.
+//
+// Usage: PeopleCounterStreams [streams] [ticks] [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../peopleDetector/DetectionPool.hpp"
+#include "../peopleDetector/Metrics.hpp"
+#include "../peopleDetector/StreamExecutor.hpp"
+
+std::mutex cout_mtx_;
+using peopleDetector::Detection;
+using peopleDetector::DetectionPool;
+using peopleDetector::LatencyHistogram;
+using peopleDetector::StreamExecutor;
+using peopleDetector::WorkStealingPool;
+
+// ################### Settings ###################
+const int frameWidth = 1280;
+const int frameHeight = 720;
+const double busySpawnProbability = 1.0 / 4; // New person per frame on stream 0
+const double missProbability = 0.05;
+const int backlogFrames = 20000; // Queued at once on stream 0 for the fairness check
+// ################################################
+
+struct Walker {
+	float x, y, vx;
+};
+
+struct Scene {
+	std::mt19937 rng;
+	double spawnProbability;
+	std::vector<Walker> walkers;
+	DetectionPool pool;
+};
+
+static void advance(Scene& scene, StreamExecutor::DetectionVec& detections)
+{
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	if (uniform(scene.rng) < scene.spawnProbability) {
+		const bool fromLeft = uniform(scene.rng) < 0.5;
+		const float speed = 3.0f + 5.0f * uniform(scene.rng);
+		scene.walkers.push_back({fromLeft ? 0.0f : (float)frameWidth, 150.0f + (frameHeight - 300) * (float)uniform(scene.rng),
+					 fromLeft ? speed : -speed});
+	}
+	for (auto& walker : scene.walkers)
+		walker.x += walker.vx;
+	scene.walkers.erase(std::remove_if(scene.walkers.begin(), scene.walkers.end(),
+					   [](const Walker& w) { return w.x < -50.0f || w.x > frameWidth + 50.0f; }),
+			    scene.walkers.end());
+
+	for (const auto& walker : scene.walkers) {
+		if (uniform(scene.rng) < missProbability)
+			continue;
+		Detection det;
+		det.Left = walker.x - 30;
+		det.Right = walker.x + 30;
+		det.Top = walker.y - 80;
+		det.Bottom = walker.y + 80;
+		det.ClassID = 1;
+		det.Confidence = 0.9f;
+		detections.push_back(scene.pool.acquire(det));
+	}
+}
+
+// True if the other streams got their frame while stream 0 still had at
+// least half of its backlog waiting
+static bool checkBacklog(int numStreams)
+{
+	WorkStealingPool pool(1);
+	StreamExecutor executor(pool);
+	std::vector<Scene> scenes(numStreams);
+	for (int s = 0; s < numStreams; ++s) {
+		executor.addStream();
+		scenes[s].rng.seed(s + 1);
+		scenes[s].spawnProbability = busySpawnProbability;
+	}
+
+	// Frames are made up front, so the backlog is queued faster than the
+	// worker gets through it. They hold copies, the scene pools would
+	// otherwise grow to the whole backlog.
+	std::vector<StreamExecutor::DetectionVec> frames(backlogFrames + numStreams - 1);
+	for (int i = 0; i < (int)frames.size(); ++i) {
+		advance(scenes[i < backlogFrames ? 0 : i - backlogFrames + 1], frames[i]);
+		for (auto& det : frames[i])
+			det = std::make_shared<Detection>(*det);
+	}
+
+	for (int frame = 0; frame < backlogFrames; ++frame)
+		executor.submit(0, frame, std::move(frames[frame]));
+	// Spinning rather than sleeping, so on few cores the other frames
+	// arrive when the scheduler preempts the worker, in the middle of a
+	// drain task of stream 0 rather than right after one
+	while (executor.getFramesProcessed(0) < 100)
+		;
+	for (int s = 1; s < numStreams; ++s)
+		executor.submit(s, 0, std::move(frames[backlogFrames + s - 1]));
+
+	uint64_t backlogDone = 0;
+	for (;;) {
+		backlogDone = executor.getFramesProcessed(0);
+		bool othersDone = true;
+		for (int s = 1; s < numStreams; ++s)
+			othersDone &= executor.getFramesProcessed(s) == 1;
+		if (othersDone)
+			break;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	executor.wait();
+
+	const bool fair = backlogDone < backlogFrames / 2;
+	printf("%s  with a backlog of %d frames on stream 0, the other %d streams were done after %llu of them\n", fair ? "PASS" : "FAIL",
+	       backlogFrames, numStreams - 1, (unsigned long long)backlogDone);
+	return fair;
+}
+
+int main(int argc, char** argv)
+{
+	const int numStreams = argc > 1 ? atoi(argv[1]) : 16;
+	const int ticks = argc > 2 ? atoi(argv[2]) : 10000;
+	const int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+	WorkStealingPool pool(threads);
+	StreamExecutor executor(pool);
+	std::vector<Scene> scenes(numStreams);
+	for (int s = 0; s < numStreams; ++s) {
+		executor.addStream();
+		scenes[s].rng.seed(s + 1);
+		// Load falls off steeply, every fourth stream sees nobody at all
+		scenes[s].spawnProbability = s % 4 == 3 ? 0.0 : busySpawnProbability / (1 + s * s);
+	}
+
+	LatencyHistogram tickLatency;
+	const auto start = std::chrono::steady_clock::now();
+	for (int tick = 0; tick < ticks; ++tick) {
+		const auto tickStart = std::chrono::steady_clock::now();
+		for (int s = 0; s < numStreams; ++s) {
+			StreamExecutor::DetectionVec detections;
+			advance(scenes[s], detections);
+			executor.submit(s, tick, std::move(detections));
+		}
+		executor.wait();
+		tickLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tickStart).count());
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (int s = 0; s < numStreams; ++s) {
+		const auto& counter = executor.getCounter(s);
+		printf("stream %3d  frames %8llu  in %6d  out %6d  tracks %4d\n", s, (unsigned long long)executor.getFramesProcessed(s),
+		       counter.getEntered(), counter.getLeft(), executor.getTracker(s).getTrackCount());
+	}
+	printf("streams: %d streams x %d ticks in %.2f s, %.0f stream frames/s, tick p50 %u us p99 %u us\n", numStreams, ticks, seconds,
+	       (double)numStreams * ticks / seconds, tickLatency.percentileUs(0.5), tickLatency.percentileUs(0.99));
+	printf("pool: %d threads, utilisation %.1f %%, %llu tasks, %llu steals\n", pool.getThreadCount(), pool.getUtilisation() * 100,
+	       (unsigned long long)pool.getTasksRun(), (unsigned long long)pool.getSteals());
+	for (int w = 0; w < pool.getThreadCount(); ++w)
+		printf("  worker %2d busy %.2f s\n", w, pool.getBusyNs(w) / 1e9);
+
+	return checkBacklog(std::max(numStreams, 2)) ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// Self-check of the tile planner, needs neither camera nor network. Plans
+// the crops for a 1280x720 frame with predicted tracks scattered over it,
+// checks that the counting line and the tracks nearest to it are covered
+// within the tile budget, then feeds synthetic per-tile detections through
+// the cross-tile NMS: a person cut by a crop edge must come back as one
+// full box, neighbours and other classes must stay separate.
+//
+// Usage: PeopleCounterTiles
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../peopleDetector/TilePlanner.hpp"
+
+using peopleDetector::Detection;
+using peopleDetector::Tile;
+using peopleDetector::TilePlanner;
+
+// ################### Settings ###################
+const int frameWidth = 1280;
+const int frameHeight = 720;
+const float countingLineX = 640.0f;
+// ################################################
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	printf("%s  %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		++failures;
+}
+
+static Detection box(float left, float top, float right, float bottom, float confidence, uint32_t classId = 1)
+{
+	Detection det;
+	det.Left = left;
+	det.Top = top;
+	det.Right = right;
+	det.Bottom = bottom;
+	det.Confidence = confidence;
+	det.ClassID = classId;
+	det.Instance = 0;
+	return det;
+}
+
+static bool inside(const Tile* tiles, int first, int numTiles, float x, float y)
+{
+	for (int i = first; i < numTiles; ++i) {
+		if (tiles[i].contains(x, y, 0.0f))
+			return true;
+	}
+	return false;
+}
+
+int main()
+{
+	TilePlanner planner;
+	Tile tiles[TilePlanner::maxPlannedTiles];
+
+	// Planning: two tracks near the line, one far from it
+	const float points[] = {700.0f, 100.0f, 560.0f, 600.0f, 1200.0f, 360.0f};
+	const int numTiles = planner.plan(frameWidth, frameHeight, countingLineX, points, 3, tiles);
+	printf("%i tiles:", numTiles);
+	for (int i = 0; i < numTiles; ++i)
+		printf(" [%i,%i %ix%i]", tiles[i].left, tiles[i].top, tiles[i].width(), tiles[i].height());
+	printf("\n");
+
+	check(numTiles <= 1 + planner._maxTiles, "tile budget respected");
+	check(tiles[0].left == 0 && tiles[0].top == 0 && tiles[0].right == frameWidth && tiles[0].bottom == frameHeight,
+	      "first tile is the full frame");
+	bool inFrame = true;
+	for (int i = 0; i < numTiles; ++i)
+		inFrame &= tiles[i].left >= 0 && tiles[i].top >= 0 && tiles[i].right <= frameWidth && tiles[i].bottom <= frameHeight;
+	check(inFrame, "tiles lie inside the frame");
+	bool lineCovered = true;
+	for (int y = 0; y < frameHeight; y += 8)
+		lineCovered &= inside(tiles, 1, numTiles, countingLineX, y);
+	check(lineCovered, "counting line covered by crops");
+	check(inside(tiles, 1, numTiles, 700.0f, 100.0f) && inside(tiles, 1, numTiles, 560.0f, 600.0f), "tracks near the line covered");
+	check(inside(tiles, 1, numTiles, 1200.0f, 360.0f), "far track covered by the remaining budget");
+
+	const int smallTiles = planner.plan(320, 240, 160.0f, points, 3, tiles);
+	check(smallTiles == 1, "small frames are not tiled");
+
+	// Merging: a person cut by a crop edge, found whole in the full frame
+	// and truncated (but more confidently) in the crop
+	std::vector<Detection> detections = {
+	    box(600.0f, 200.0f, 640.0f, 320.0f, 0.9f), // truncated at a crop edge
+	    box(600.0f, 200.0f, 660.0f, 320.0f, 0.6f), // same person, full frame
+	    box(602.0f, 198.0f, 641.0f, 322.0f, 0.7f), // same person, another crop
+	    box(700.0f, 200.0f, 760.0f, 320.0f, 0.8f), // neighbour
+	    box(650.0f, 200.0f, 710.0f, 320.0f, 0.5f), // between the two, overlapping both a little
+	    box(600.0f, 200.0f, 660.0f, 320.0f, 0.6f, 2), // other class at the same place
+	};
+	const int kept = planner.merge(detections.data(), detections.size());
+	for (int i = 0; i < kept; ++i)
+		printf("  kept class %u %.2f [%.0f,%.0f %.0f,%.0f]\n", detections[i].ClassID, detections[i].Confidence, detections[i].Left,
+		       detections[i].Top, detections[i].Right, detections[i].Bottom);
+
+	check(kept == 4, "duplicates merged, distinct boxes kept");
+	check(detections[0].Confidence == 0.9f && detections[0].Left == 600.0f && detections[0].Right == 660.0f,
+	      "truncated box grown to the full extent");
+	bool ordered = true;
+	for (int i = 1; i < kept; ++i)
+		ordered &= detections[i - 1].Confidence >= detections[i].Confidence && detections[i].Instance == (uint32_t)i;
+	check(ordered, "ordered by confidence, instances renumbered");
+	bool otherClass = false;
+	for (int i = 0; i < kept; ++i)
+		otherClass |= detections[i].ClassID == 2;
+	check(otherClass, "classes are never merged");
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}